@@ -56,7 +56,7 @@ namespace VkMana::SamplesApp
     {
         auto& window = app.GetWindow();
 
-        auto depthImageInfo = VkMana::ImageCreateInfo::DepthStencilTarget(window.GetSurfaceWidth(), window.GetSurfaceHeight(), false);
+        auto depthImageInfo = VkMana::ImageCreateInfo::TransientDepthStencilTarget(window.GetSurfaceWidth(), window.GetSurfaceHeight(), false);
         m_depthTarget = ctx.CreateImage(depthImageInfo, nullptr);
 
         std::vector<VkMana::SetLayoutBinding> setBindings{
@@ -39,18 +39,22 @@ namespace VkMana::SamplesApp
                 pixels.assign(gltfImage.image.begin(), gltfImage.image.end());
             }
 
-            const auto imageInfo = ImageCreateInfo::Texture(gltfImage.width, gltfImage.height);
+            auto imageInfo = ImageCreateInfo::Texture(gltfImage.width, gltfImage.height);
+            imageInfo.flags = ImageCreateFlags_GenMipMapsCompute;
             const ImageDataSource imageDataSrc{ .size = pixels.size(), .data = pixels.data() };
             return context.CreateImage(imageInfo, &imageDataSrc);
         }
 
         auto LoadGLTFImages(tinygltf::Model& gltfModel, Context& context) -> std::vector<ImageHandle>
         {
+            // Upload all images with a single submission.
+            context.BeginUploadBatch();
             std::vector<ImageHandle> images;
             for(auto& image : gltfModel.images)
             {
                 images.push_back(LoadGLTFImage(image, context));
             }
+            context.EndUploadBatch();
             return images;
         }
 
@@ -243,8 +247,7 @@ namespace VkMana::SamplesApp
             Utils::LoadGLTFNode(nullptr, node, scene.nodes[i], gltfModel, glm::mat4(1.0f), vertices, triangles, submeshes);
         }
 
-        mesh.SetVertices(vertices);
-        mesh.SetTriangles(triangles);
+        mesh.SetGeometry(vertices, triangles);
         mesh.SetMaterials(materials);
         mesh.SetSubmeshes(submeshes);
 
@@ -3,10 +3,15 @@
 
 #include <VkMana/ShaderCompiler.hpp>
 
+#include <algorithm>
 #include <fstream>
 #include <string>
 
 constexpr auto MaxBindlessImages = 100;
+constexpr auto MaxGBufferRecordThreads = 4u;
+constexpr auto MinInstancesPerRecordThread = 64u;
+constexpr auto MaxGeometryVertices = 1024u * 1024u;
+constexpr auto MaxGeometryIndices = 4u * 1024u * 1024u;
 
 using namespace VkMana;
 
@@ -32,6 +37,15 @@ namespace VkMana::SamplesApp
             m_whiteImage->SetDebugName("Black");
         }
 
+        m_geometryPool = m_ctx->CreateGeometryPool({
+            .vertexStride = sizeof(StaticVertex),
+            .vertexCapacity = MaxGeometryVertices,
+            .indexCapacity = MaxGeometryIndices,
+            .indexType = vk::IndexType::eUint16,
+        });
+        if(m_geometryPool == nullptr)
+            return false;
+
         m_bindlessSetLayout = m_ctx->CreateSetLayout({
             { 0,
              vk::DescriptorType::eCombinedImageSampler,
@@ -40,13 +54,30 @@ namespace VkMana::SamplesApp
         });
         // #TODO: m_bindlessSetLayout->SetDebugName("Bindless");
 
+        SetupRenderTargets();
         SetupGBufferPass();
         SetupCompositionPass();
         SetupScreenPass();
 
+        const auto recordThreadCount = std::clamp(std::thread::hardware_concurrency(), 1u, MaxGBufferRecordThreads);
+        m_recordJobs.resize(recordThreadCount);
+        for(auto i = 0u; i < recordThreadCount; ++i)
+            m_recordThreads.emplace_back(&Renderer::RecordThreadLoop, this, i);
+
         return true;
     }
 
+    Renderer::~Renderer()
+    {
+        {
+            std::lock_guard lock(m_recordMutex);
+            m_stopRecordThreads = true;
+        }
+        m_recordStartCondition.notify_all();
+        for(auto& thread : m_recordThreads)
+            thread.join();
+    }
+
     void Renderer::SetSceneCamera(const glm::mat4& projMatrix, const glm::mat4& viewMatrix)
     {
         m_cameraUniformData.projMatrix = projMatrix;
@@ -99,12 +130,35 @@ namespace VkMana::SamplesApp
 
     auto Renderer::CreateStaticMesh() -> StaticMeshHandle { return IntrusivePtr(new StaticMesh(this)); }
 
-    void Renderer::SetupGBufferPass()
+    void Renderer::SetupRenderTargets()
     {
-        const auto depthImageInfo = ImageCreateInfo::DepthStencilTarget(m_mainWindow->GetSurfaceWidth(), m_mainWindow->GetSurfaceHeight(), false);
-        m_depthTargetImage = m_ctx->CreateImage(depthImageInfo);
+        const auto width = m_mainWindow->GetSurfaceWidth();
+        const auto height = m_mainWindow->GetSurfaceHeight();
+
+        // Depth is only used within the G-Buffer pass & the composition target only after it.
+        const auto depthImageInfo = ImageCreateInfo::TransientDepthStencilTarget(width, height, false);
+        const auto compositionImageInfo = ImageCreateInfo::ColorTarget(width, height, vk::Format::eR8G8B8A8Unorm);
+        if(!m_ctx->GetGPUInfo().SupportsLazilyAllocatedMemory)
+        {
+            // Depth would be fully backed, so share its memory with the composition target instead.
+            auto images = m_ctx->CreateAliasedImages({ depthImageInfo, compositionImageInfo });
+            if(!images.empty())
+            {
+                m_depthTargetImage = images[0];
+                m_compositionTargetImage = images[1];
+            }
+        }
+        if(!m_depthTargetImage)
+        {
+            m_depthTargetImage = m_ctx->CreateImage(depthImageInfo);
+            m_compositionTargetImage = m_ctx->CreateImage(compositionImageInfo);
+        }
         m_depthTargetImage->SetDebugName("Sandbox_DepthTarget");
+        m_compositionTargetImage->SetDebugName("Sandbox_CompositeTarget");
+    }
 
+    void Renderer::SetupGBufferPass()
+    {
         const auto positionImageInfo
             = ImageCreateInfo::ColorTarget(m_mainWindow->GetSurfaceWidth(), m_mainWindow->GetSurfaceHeight(), vk::Format::eR16G16B16A16Sfloat);
         m_positionTargetImage = m_ctx->CreateImage(positionImageInfo);
@@ -128,10 +182,14 @@ namespace VkMana::SamplesApp
         };
 
         m_cameraSetLayout = m_ctx->CreateSetLayout({
-            { 0, vk::DescriptorType::eUniformBuffer, 1, vk::ShaderStageFlagBits::eVertex },
+            { 0, vk::DescriptorType::eUniformBufferDynamic, 1, vk::ShaderStageFlagBits::eVertex },
         });
         // #TODO: m_cameraSetLayout->SetDebugName()
 
+        // Written once, the camera data is placed in the transient buffer each frame & selected with a dynamic offset.
+        m_cameraSet = m_ctx->CreateDescriptorSet(m_cameraSetLayout.Get());
+        m_cameraSet->Write(0, m_ctx->GetTransientBuffer(), 0, sizeof(CameraUniformData), vk::DescriptorType::eUniformBufferDynamic);
+
         const PipelineLayoutCreateInfo layoutInfo{
             .PushConstantRange = { vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(PushConstantData) },
             .SetLayouts = { m_bindlessSetLayout.Get(), m_cameraSetLayout.Get() },
@@ -181,19 +239,10 @@ namespace VkMana::SamplesApp
         };
         m_gBufferStaticPipeline = m_ctx->CreateGraphicsPipeline(pipelineInfo);
         m_gBufferStaticPipeline->SetDebugName("Sandbox_Static");
-
-        const auto cameraUniformBufferInfo = BufferCreateInfo::Uniform(sizeof(m_cameraUniformData) * 2);
-        m_cameraUniformBuffer = m_ctx->CreateBuffer(cameraUniformBufferInfo);
-        m_cameraUniformBuffer->SetDebugName("Sandbox_Camera_Uniforms");
     }
 
     void Renderer::SetupCompositionPass()
     {
-        const auto compositionImageInfo
-            = ImageCreateInfo::ColorTarget(m_mainWindow->GetSurfaceWidth(), m_mainWindow->GetSurfaceHeight(), vk::Format::eR8G8B8A8Unorm);
-        m_compositionTargetImage = m_ctx->CreateImage(compositionImageInfo);
-        m_compositionTargetImage->SetDebugName("Sandbox_CompositeTarget");
-
         m_compositionPass.targets = {
             RenderPassTarget::DefaultColorTarget(m_compositionTargetImage->GetImageView(ImageViewType::RenderTarget)),
         };
@@ -290,30 +339,63 @@ namespace VkMana::SamplesApp
 
     void Renderer::GBufferPass(CmdBuffer& cmd)
     {
-        auto* dataPtr = m_cameraUniformBuffer->Map() + (sizeof(CameraUniformData) * m_ctx->GetFrameIndex());
-        std::memcpy(dataPtr, &m_cameraUniformData, sizeof(CameraUniformData));
-        m_cameraUniformBuffer->Unmap();
+        const auto cameraData = m_ctx->AllocateTransient(sizeof(CameraUniformData));
+        if(cameraData.pData == nullptr)
+            return;
+        std::memcpy(cameraData.pData, &m_cameraUniformData, sizeof(CameraUniformData));
+
+        // Split instances across the recording threads, each recording into its own secondary command buffer.
+        const auto instanceCount = uint32_t(m_staticInstances.size());
+        const auto threadCount = std::clamp(instanceCount / MinInstancesPerRecordThread, 1u, uint32_t(m_recordThreads.size()));
+        const auto instancesPerThread = (instanceCount + threadCount - 1) / threadCount;
 
-        auto cameraSet = m_ctx->RequestDescriptorSet(m_cameraSetLayout.Get());
-        cameraSet->Write(
-            0,
-            m_cameraUniformBuffer.Get(),
-            sizeof(CameraUniformData) * m_ctx->GetFrameIndex(),
-            sizeof(CameraUniformData),
-            vk::DescriptorType::eUniformBuffer
-        );
+        std::unique_lock lock(m_recordMutex);
+        for(auto i = 0u; i < m_recordJobs.size(); ++i)
+        {
+            const auto first = std::min(i * instancesPerThread, instanceCount);
+            m_recordJobs[i] = {
+                .Active = i < threadCount,
+                .CameraOffset = cameraData.Offset,
+                .FirstInstance = first,
+                .LastInstance = std::min(first + instancesPerThread, instanceCount),
+            };
+        }
+        m_pendingRecordJobs = threadCount;
+        ++m_recordGeneration;
+        m_recordStartCondition.notify_all();
+        m_recordDoneCondition.wait(lock, [this] { return m_pendingRecordJobs == 0; });
+
+        std::vector<CmdBuffer> secondaryCmds;
+        for(auto i = 0u; i < threadCount; ++i)
+            secondaryCmds.push_back(std::move(m_recordJobs[i].Cmd));
+        lock.unlock();
+
+        cmd->BeginRenderPass(m_gBufferPass, true);
+        cmd->ExecuteCommands(secondaryCmds);
+        cmd->EndRenderPass();
+
+        m_staticInstances.clear();
+    }
 
-        cmd->BeginRenderPass(m_gBufferPass);
+    void Renderer::RecordGBufferInstances(CmdBuffer& cmd, uint32_t cameraOffset, uint32_t firstInstance, uint32_t lastInstance)
+    {
+        // Dynamic state & bindings are not inherited by secondary command buffers.
+        cmd->SetViewport(0, float(m_mainWindow->GetSurfaceHeight()), float(m_mainWindow->GetSurfaceWidth()), -float(m_mainWindow->GetSurfaceHeight()));
+        cmd->SetScissor(0, 0, m_mainWindow->GetSurfaceWidth(), m_mainWindow->GetSurfaceHeight());
 
         cmd->BindPipeline(m_gBufferStaticPipeline.Get());
-        cmd->BindDescriptorSets(0, { m_bindlessSet.Get(), cameraSet.Get() }, {});
+        cmd->BindDescriptorSets(0, { m_bindlessSet.Get(), m_cameraSet.Get() }, { cameraOffset });
+        m_geometryPool->Bind(cmd);
 
-        for(const auto& instance : m_staticInstances)
+        PushConstantData pushConstantData{};
+        for(auto i = firstInstance; i < lastInstance; ++i)
         {
-            m_pushConstantData.modelMatrix = instance.Transform;
+            const auto& instance = m_staticInstances[i];
+            pushConstantData.modelMatrix = instance.Transform;
 
-            cmd->BindIndexBuffer(instance.Mesh->GetIndexBuffer(), 0);
-            cmd->BindVertexBuffers(0, { instance.Mesh->GetVertexBuffer() }, { 0 });
+            const auto* geometry = instance.Mesh->GetGeometry();
+            if(geometry == nullptr)
+                continue;
 
             auto& materials = instance.Mesh->GetMaterials();
             for(auto& submesh : instance.Mesh->GetSubmeshes())
@@ -322,17 +404,40 @@ namespace VkMana::SamplesApp
                 auto* albedoImage = material->GetAlbedoTexture();
                 auto* normalImage = material->GetNormalTexture();
 
-                m_pushConstantData.albedoMapIndex = GetImageIndex(albedoImage ? albedoImage : m_whiteImage.Get());
-                m_pushConstantData.normalMapIndex = GetImageIndex(normalImage ? normalImage : m_blackImage.Get());
-                cmd->SetPushConstants(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(PushConstantData), &m_pushConstantData);
+                // Images were registered by Submit/Flush, so lookups are read-only & safe across record threads.
+                pushConstantData.albedoMapIndex = FindImageIndex(albedoImage ? albedoImage : m_whiteImage.Get());
+                pushConstantData.normalMapIndex = FindImageIndex(normalImage ? normalImage : m_blackImage.Get());
+                cmd->SetPushConstants(vk::ShaderStageFlagBits::eVertex | vk::ShaderStageFlagBits::eFragment, 0, sizeof(PushConstantData), &pushConstantData);
 
-                cmd->DrawIndexed(submesh.IndexCount, submesh.IndexOffset, submesh.VertexOffset);
+                cmd->DrawIndexed(submesh.IndexCount, geometry->GetIndexOffset() + submesh.IndexOffset, geometry->GetVertexOffset() + submesh.VertexOffset);
             }
         }
+    }
 
-        cmd->EndRenderPass();
-
-        m_staticInstances.clear();
+    void Renderer::RecordThreadLoop(uint32_t threadIndex)
+    {
+        uint64_t generation = 0;
+        while(true)
+        {
+            std::unique_lock lock(m_recordMutex);
+            m_recordStartCondition.wait(lock, [&] { return m_stopRecordThreads || m_recordGeneration != generation; });
+            if(m_stopRecordThreads)
+                return;
+
+            generation = m_recordGeneration;
+            auto& job = m_recordJobs[threadIndex];
+            if(!job.Active)
+                continue;
+            lock.unlock();
+
+            // The job is only touched by this thread until it is reported done.
+            job.Cmd = m_ctx->RequestSecondaryCmd(m_gBufferPass);
+            RecordGBufferInstances(job.Cmd, job.CameraOffset, job.FirstInstance, job.LastInstance);
+
+            lock.lock();
+            if(--m_pendingRecordJobs == 0)
+                m_recordDoneCondition.notify_one();
+        }
     }
 
     void Renderer::CompositionPass(CmdBuffer& cmd)
@@ -375,6 +480,8 @@ namespace VkMana::SamplesApp
         return index;
     }
 
+    auto Renderer::FindImageIndex(const Image* image) const -> uint32_t { return m_knownBindlessImages.at(image); }
+
     auto Renderer::GetMaterialIndex(const Material* material) -> uint32_t
     {
         const auto it = m_knownMaterials.find(material);
@@ -8,6 +8,9 @@
 
 #include <glm/ext/matrix_float4x4.hpp>
 
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 #include <unordered_map>
 
 namespace VkMana::SamplesApp
@@ -16,7 +19,7 @@ namespace VkMana::SamplesApp
     {
     public:
         Renderer() = default;
-        ~Renderer() = default;
+        ~Renderer();
 
         /* State */
 
@@ -36,17 +39,22 @@ namespace VkMana::SamplesApp
         /* Getters */
 
         auto GetContext() const -> auto { return m_ctx; }
+        auto GetGeometryPool() -> auto { return m_geometryPool.Get(); }
 
     private:
+        void SetupRenderTargets();
         void SetupGBufferPass();
         void SetupCompositionPass();
         void SetupScreenPass();
 
         void GBufferPass(CmdBuffer& cmd);
+        void RecordGBufferInstances(CmdBuffer& cmd, uint32_t cameraOffset, uint32_t firstInstance, uint32_t lastInstance);
+        void RecordThreadLoop(uint32_t threadIndex);
         void CompositionPass(CmdBuffer& cmd);
         void ScreenPass(CmdBuffer& cmd, SwapChainHandle pSwapChain);
 
         auto GetImageIndex(Image* image) -> uint32_t;
+        auto FindImageIndex(const Image* image) const -> uint32_t;
         auto GetMaterialIndex(const Material* material) -> uint32_t;
 
     private:
@@ -56,6 +64,8 @@ namespace VkMana::SamplesApp
         ImageHandle m_whiteImage = nullptr;
         ImageHandle m_blackImage = nullptr;
 
+        GeometryPoolHandle m_geometryPool = nullptr; // Vertices & indices of every mesh, bound once per pass.
+
         /* Pass Resources */
 
         SetLayoutHandle m_bindlessSetLayout = nullptr;
@@ -68,10 +78,11 @@ namespace VkMana::SamplesApp
         RenderPassInfo m_gBufferPass;
 
         SetLayoutHandle m_cameraSetLayout = nullptr;
+        DescriptorSetHandle m_cameraSet = nullptr;
         PipelineLayoutHandle m_gBufferPipelineLayout = nullptr;
         PipelineHandle m_gBufferStaticPipeline = nullptr;
 
-        ImageHandle m_compositionTargetImage;
+        ImageHandle m_compositionTargetImage; // May alias m_depthTargetImage.
         RenderPassInfo m_compositionPass;
 
         SetLayoutHandle m_compositionSetLayout = nullptr;
@@ -89,14 +100,13 @@ namespace VkMana::SamplesApp
             glm::mat4 projMatrix = glm::mat4(1.0f);
             glm::mat4 viewMatrix = glm::mat4(1.0f);
         } m_cameraUniformData;
-        BufferHandle m_cameraUniformBuffer = nullptr;
 
         struct PushConstantData
         {
             glm::mat4 modelMatrix = glm::mat4(1.0f);
             uint32_t albedoMapIndex = 0;
             uint32_t normalMapIndex = 0;
-        } m_pushConstantData;
+        };
 
         /* Renderables */
 
@@ -111,6 +121,26 @@ namespace VkMana::SamplesApp
 
         std::vector<Instance<StaticMesh>> m_staticInstances;
 
+        /* Recording Threads */
+
+        struct RecordJob
+        {
+            bool Active = false;
+            uint32_t CameraOffset = 0;
+            uint32_t FirstInstance = 0;
+            uint32_t LastInstance = 0;
+            CmdBuffer Cmd = nullptr; // Recorded secondary command buffer.
+        };
+        // Persistent, so each thread keeps reusing its command pools instead of new threads creating new pools every frame.
+        std::vector<std::thread> m_recordThreads;
+        std::vector<RecordJob> m_recordJobs; // One per thread.
+        std::mutex m_recordMutex;
+        std::condition_variable m_recordStartCondition;
+        std::condition_variable m_recordDoneCondition;
+        uint64_t m_recordGeneration = 0; // Incremented to start the jobs of a frame.
+        uint32_t m_pendingRecordJobs = 0;
+        bool m_stopRecordThreads = false;
+
         std::unordered_map<const Image*, uint32_t> m_knownBindlessImages;
         std::vector<const ImageView*> m_bindlessImages;
 
@@ -53,30 +53,19 @@ namespace VkMana::SamplesApp
             }
         }
 
-        SetVertices(vertices);
-        SetTriangles(indices);
+        SetGeometry(vertices, indices);
 
         return true;
     }
 
-    void StaticMesh::SetVertices(const std::vector<StaticVertex>& vertices)
+    void StaticMesh::SetGeometry(const std::vector<StaticVertex>& vertices, const std::vector<uint16_t>& triangles)
     {
-        const auto bufferInfo = BufferCreateInfo::Vertex(sizeof(StaticVertex) * vertices.size());
-        const BufferDataSource initialData{
-            .size = bufferInfo.size,
-            .pData = vertices.data(),
-        };
-        m_vertexBuffer = m_renderer->GetContext()->CreateBuffer(bufferInfo, &initialData);
-    }
+        auto* geometryPool = m_renderer->GetGeometryPool();
+        m_geometry = geometryPool->Allocate(uint32_t(vertices.size()), uint32_t(triangles.size()));
+        if(m_geometry == nullptr)
+            return;
 
-    void StaticMesh::SetTriangles(const std::vector<uint16_t>& triangles)
-    {
-        const auto bufferInfo = BufferCreateInfo::Index(sizeof(uint16_t) * triangles.size());
-        const BufferDataSource initialData{
-            .size = bufferInfo.size,
-            .pData = triangles.data(),
-        };
-        m_indexBuffer = m_renderer->GetContext()->CreateBuffer(bufferInfo, &initialData);
+        geometryPool->Upload(m_geometry.Get(), vertices.data(), triangles.data());
     }
 
     void StaticMesh::SetSubmeshes(const std::vector<Submesh>& submeshes) { m_submeshes = submeshes; }
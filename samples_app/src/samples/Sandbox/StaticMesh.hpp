@@ -2,7 +2,7 @@
 
 #include "Material.hpp"
 
-#include <VkMana/Buffer.hpp>
+#include <VkMana/GeometryPool.hpp>
 
 #include <glm/ext/vector_float2.hpp>
 #include <glm/ext/vector_float3.hpp>
@@ -41,8 +41,7 @@ namespace VkMana::SamplesApp
 
         bool LoadFromFile(const std::string& filename);
 
-        void SetVertices(const std::vector<StaticVertex>& vertices);
-        void SetTriangles(const std::vector<uint16_t>& triangles);
+        void SetGeometry(const std::vector<StaticVertex>& vertices, const std::vector<uint16_t>& triangles);
         void SetSubmeshes(const std::vector<Submesh>& submeshes);
         void SetMaterials(const std::vector<MaterialHandle>& materials);
 
@@ -54,14 +53,12 @@ namespace VkMana::SamplesApp
 
         explicit StaticMesh(Renderer* renderer);
 
-        auto GetVertexBuffer() const -> auto { return m_vertexBuffer.Get(); }
-        auto GetIndexBuffer() const -> auto { return m_indexBuffer.Get(); }
+        auto GetGeometry() const -> auto { return m_geometry.Get(); }
 
     private:
         Renderer* m_renderer;
 
-        BufferHandle m_vertexBuffer = nullptr;
-        BufferHandle m_indexBuffer = nullptr;
+        GeometryRangeHandle m_geometry = nullptr; // From the Renderer's geometry pool.
         std::vector<Submesh> m_submeshes;
         std::vector<MaterialHandle> m_materials;
     };
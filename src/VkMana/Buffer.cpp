@@ -1,5 +1,6 @@
 #include "Buffer.hpp"
 
+#include "CommandBuffer.hpp"
 #include "Context.hpp"
 
 namespace VkMana
@@ -22,15 +23,36 @@ namespace VkMana
         }
 
         auto pBuffer = IntrusivePtr(new Buffer(pContext, buffer, allocation, info));
+
+        const auto memProps = pContext->GetAllocator().getAllocationMemoryProperties(allocation);
+        const auto allocationInfo = pContext->GetAllocator().getAllocationInfo(allocation);
+        pBuffer->m_isHostCoherent = bool(memProps & vk::MemoryPropertyFlagBits::eHostCoherent);
+        if(info.allocFlags & vma::AllocationCreateFlagBits::eMapped)
+            pBuffer->m_pMapped = static_cast<uint8_t*>(allocationInfo.pMappedData);
+
+        const auto transferUsage = vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+        const bool isStaging = pBuffer->IsHostAccessible() && !(info.usage & ~transferUsage);
+        pBuffer->m_memoryCategory = isStaging ? MemoryCategory::Staging : MemoryCategory::Buffer;
+        pBuffer->m_allocationSize = allocationInfo.size;
+        pContext->AddMemoryUsage(pBuffer->m_memoryCategory, pBuffer->m_allocationSize);
+        // Moves are copies, and mapped pointers would change.
+        if(!pBuffer->IsHostAccessible() && (info.usage & transferUsage) == transferUsage)
+            pContext->RegisterMovable(allocation, pBuffer.Get(), nullptr);
+
         return pBuffer;
     }
 
     Buffer::~Buffer()
     {
+        GetContext()->ForgetStaticDescriptors(this);
         if(m_buffer)
             GetContext()->DestroyBuffer(m_buffer);
         if(m_allocation)
-            GetContext()->DestroyAllocation(m_allocation);
+        {
+            GetContext()->RemoveMemoryUsage(m_memoryCategory, m_allocationSize);
+            if(!GetContext()->ReleaseMovable(m_allocation))
+                GetContext()->DestroyAllocation(m_allocation);
+        }
     }
 
     void Buffer::SetDebugName(const std::string& name)
@@ -45,18 +67,63 @@ namespace VkMana
         {
             return nullptr;
         }
+        if(m_pMapped != nullptr)
+        {
+            return m_pMapped;
+        }
 
         return static_cast<uint8_t*>(GetContext()->GetAllocator().mapMemory(m_allocation));
     }
 
     void Buffer::Unmap() const
     {
-        if(IsHostAccessible())
+        if(IsHostAccessible() && m_pMapped == nullptr)
         {
             GetContext()->GetAllocator().unmapMemory(m_allocation);
         }
     }
 
+    void Buffer::Flush(uint64_t offset, uint64_t size) const
+    {
+        if(IsHostAccessible() && !m_isHostCoherent)
+        {
+            GetContext()->GetAllocator().flushAllocation(m_allocation, offset, size);
+        }
+    }
+
+    void Buffer::Invalidate(uint64_t offset, uint64_t size) const
+    {
+        if(IsHostAccessible() && !m_isHostCoherent)
+        {
+            GetContext()->GetAllocator().invalidateAllocation(m_allocation, offset, size);
+        }
+    }
+
+    void Buffer::Update(CommandBuffer& cmd, const void* pData, uint64_t size, uint64_t offset) const
+    {
+        if(size <= InlineBufferUpdateThreshold && size % 4 == 0 && offset % 4 == 0)
+        {
+            cmd.UpdateBuffer(this, offset, size, pData);
+            return;
+        }
+
+        const auto staging = GetContext()->AllocateStaging(pData, size);
+        if(staging.pBuffer == nullptr)
+        {
+            VM_ERR("Failed to update Buffer (Staging allocation failed)");
+            return;
+        }
+
+        BufferCopyInfo copyInfo{
+            .pSrcBuffer = staging.pBuffer,
+            .pDstBuffer = this,
+            .size = size,
+            .srcOffset = staging.Offset,
+            .dstOffset = offset,
+        };
+        cmd.CopyBuffer(copyInfo);
+    }
+
     Buffer::Buffer(Context* context, vk::Buffer buffer, vma::Allocation allocation, const BufferCreateInfo& info)
         : GPUResource<Buffer>(context)
         , m_buffer(buffer)
@@ -2,9 +2,14 @@
 
 #include "VulkanCommon.hpp"
 
+#include <atomic>
+
 namespace VkMana
 {
     class Context;
+    class CommandBuffer;
+
+    constexpr uint64_t InlineBufferUpdateThreshold = 4096; // Buffer::Update records larger updates as staged copies.
 
     struct BufferCreateInfo
     {
@@ -19,14 +24,23 @@ namespace VkMana
                 .size = size,
                 .usage = vk::BufferUsageFlagBits::eTransferSrc,
                 .memUsage = vma::MemoryUsage::eAuto,
-                .allocFlags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite,
+                .allocFlags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
+            };
+        }
+        static auto Readback(uint64_t size)
+        {
+            return BufferCreateInfo{
+                .size = size,
+                .usage = vk::BufferUsageFlagBits::eTransferDst,
+                .memUsage = vma::MemoryUsage::eAuto,
+                .allocFlags = vma::AllocationCreateFlagBits::eHostAccessRandom | vma::AllocationCreateFlagBits::eMapped,
             };
         }
         static auto Vertex(uint64_t size)
         {
             return BufferCreateInfo{
                 .size = size,
-                .usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                .usage = vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
                 .memUsage = vma::MemoryUsage::eAutoPreferDevice,
             };
         }
@@ -34,7 +48,7 @@ namespace VkMana
         {
             return BufferCreateInfo{
                 .size = size,
-                .usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                .usage = vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
                 .memUsage = vma::MemoryUsage::eAutoPreferDevice,
             };
         }
@@ -44,14 +58,14 @@ namespace VkMana
                 .size = size,
                 .usage = vk::BufferUsageFlagBits::eUniformBuffer,
                 .memUsage = vma::MemoryUsage::eAutoPreferDevice,
-                .allocFlags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite,
+                .allocFlags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
             };
         }
         static auto Storage(uint64_t size)
         {
             return BufferCreateInfo{
                 .size = size,
-                .usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst,
+                .usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc,
                 .memUsage = vma::MemoryUsage::eAutoPreferDevice,
             };
         }
@@ -75,21 +89,49 @@ namespace VkMana
 
         void SetDebugName(const std::string& name) override;
 
+        /**
+         * Buffers created with vma::AllocationCreateFlagBits::eMapped stay mapped for their lifetime.
+         * Map returns the cached pointer & Unmap does nothing for them.
+         */
         auto Map() const -> uint8_t*;
         void Unmap() const;
+        void Flush(uint64_t offset = 0, uint64_t size = VK_WHOLE_SIZE) const;      // Make host writes visible to the GPU (no-op on coherent memory).
+        void Invalidate(uint64_t offset = 0, uint64_t size = VK_WHOLE_SIZE) const; // Make GPU writes visible to host reads (no-op on coherent memory).
+
+        /**
+         * Record a transfer write of pData into the buffer, which needs eTransferDst usage.
+         * Small, 4 byte aligned updates are recorded inline (vkCmdUpdateBuffer), others are copied from the frame's staging ring.
+         * Synchronising with prior & later use of the range is up to the caller.
+         */
+        void Update(CommandBuffer& cmd, const void* pData, uint64_t size, uint64_t offset = 0) const;
 
         auto GetBuffer() const -> auto { return m_buffer; }
         auto GetSize() const -> auto { return m_info.size; }
         auto GetUsage() const -> auto { return m_info.usage; }
-        auto IsHostAccessible() const -> auto { return m_info.allocFlags & vma::AllocationCreateFlagBits::eHostAccessSequentialWrite; }
+        auto GetMemoryCategory() const -> auto { return m_memoryCategory; }
+        auto GetMappedData() const -> uint8_t* { return m_pMapped; } // Null unless persistently mapped.
+        bool IsPersistentlyMapped() const { return m_pMapped != nullptr; }
+        bool IsHostCoherent() const { return m_isHostCoherent; }
+        bool IsHostAccessible() const
+        {
+            return bool(m_info.allocFlags & (vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eHostAccessRandom));
+        }
 
     private:
+        friend class Context;
+        friend class CommandBuffer;
+
         Buffer(Context* context, vk::Buffer buffer, vma::Allocation allocation, const BufferCreateInfo& info);
 
     private:
         vk::Buffer m_buffer;
         vma::Allocation m_allocation;
         BufferCreateInfo m_info;
+        uint8_t* m_pMapped = nullptr;
+        bool m_isHostCoherent = false;
+        MemoryCategory m_memoryCategory = MemoryCategory::Buffer;
+        uint64_t m_allocationSize = 0;
+        mutable std::atomic_bool m_ownedByGraphics{ true }; // False while released to/held by another queue family. Tracked by CommandBuffer barriers.
     };
 
 } // namespace VkMana
@@ -1,10 +1,133 @@
 #include "CommandBuffer.hpp"
 
+#include "Context.hpp"
 #include "Image.hpp"
 
 namespace VkMana
 {
-    void CommandBuffer::BeginRenderPass(const RenderPassInfo& info)
+    namespace
+    {
+        auto ToImageBarrier(const ImageTransitionInfo& info) -> vk::ImageMemoryBarrier2
+        {
+            vk::PipelineStageFlags2 srcStage = {};
+            vk::AccessFlags2 srcAccess = {};
+            switch(info.oldLayout)
+            {
+            case vk::ImageLayout::eUndefined:
+                if(info.pImage->IsAliased())
+                {
+                    // The memory may have last been used by another alias.
+                    srcStage = vk::PipelineStageFlagBits2::eAllCommands;
+                    srcAccess = vk::AccessFlagBits2::eMemoryWrite;
+                }
+                else
+                {
+                    srcStage = vk::PipelineStageFlagBits2::eTopOfPipe;
+                    srcAccess = vk::AccessFlagBits2::eNone;
+                }
+                break;
+            case vk::ImageLayout::eTransferSrcOptimal:
+                srcStage = vk::PipelineStageFlagBits2::eTransfer;
+                srcAccess = vk::AccessFlagBits2::eTransferRead;
+                break;
+            case vk::ImageLayout::eTransferDstOptimal:
+                srcStage = vk::PipelineStageFlagBits2::eTransfer;
+                srcAccess = vk::AccessFlagBits2::eTransferWrite;
+                break;
+            case vk::ImageLayout::eColorAttachmentOptimal:
+                srcStage = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+                srcAccess = vk::AccessFlagBits2::eColorAttachmentWrite;
+                break;
+            case vk::ImageLayout::eDepthStencilAttachmentOptimal:
+                srcStage = vk::PipelineStageFlagBits2::eLateFragmentTests;
+                srcAccess = vk::AccessFlagBits2::eDepthStencilAttachmentWrite;
+                break;
+            case vk::ImageLayout::eShaderReadOnlyOptimal:
+                srcStage = vk::PipelineStageFlagBits2::eFragmentShader;
+                srcAccess = vk::AccessFlagBits2::eShaderRead;
+                break;
+            case vk::ImageLayout::eGeneral: // Compute storage image
+                srcStage = vk::PipelineStageFlagBits2::eComputeShader;
+                srcAccess = vk::AccessFlagBits2::eShaderStorageWrite;
+                break;
+            default:
+                assert(false);
+                break;
+            }
+
+            vk::PipelineStageFlags2 dstStage = {};
+            vk::AccessFlags2 dstAccess = {};
+            switch(info.newLayout)
+            {
+            case vk::ImageLayout::eTransferSrcOptimal:
+                dstStage = vk::PipelineStageFlagBits2::eTransfer;
+                dstAccess = vk::AccessFlagBits2::eTransferRead;
+                break;
+            case vk::ImageLayout::eTransferDstOptimal:
+                dstStage = vk::PipelineStageFlagBits2::eTransfer;
+                dstAccess = vk::AccessFlagBits2::eTransferWrite;
+                break;
+            case vk::ImageLayout::eColorAttachmentOptimal:
+                dstStage = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
+                dstAccess = vk::AccessFlagBits2::eColorAttachmentWrite;
+                break;
+            case vk::ImageLayout::eDepthStencilAttachmentOptimal:
+                dstStage = vk::PipelineStageFlagBits2::eEarlyFragmentTests;
+                dstAccess = vk::AccessFlagBits2::eDepthStencilAttachmentRead;
+                break;
+            case vk::ImageLayout::eShaderReadOnlyOptimal:
+                dstStage = vk::PipelineStageFlagBits2::eFragmentShader;
+                dstAccess = vk::AccessFlagBits2::eShaderRead;
+                break;
+            case vk::ImageLayout::eGeneral: // Compute storage image
+                dstStage = vk::PipelineStageFlagBits2::eComputeShader;
+                dstAccess = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite;
+                break;
+            case vk::ImageLayout::ePresentSrcKHR:
+                dstStage = vk::PipelineStageFlagBits2::eBottomOfPipe;
+                dstAccess = vk::AccessFlagBits2::eNone;
+                break;
+            default:
+                assert(false);
+                break;
+            }
+
+            vk::ImageMemoryBarrier2 barrier{};
+            barrier.setImage(info.pImage->GetImage());
+            barrier.setOldLayout(info.oldLayout);
+            barrier.setNewLayout(info.newLayout);
+            barrier.setSrcStageMask(srcStage);
+            barrier.setSrcAccessMask(srcAccess);
+            barrier.setDstStageMask(dstStage);
+            barrier.setDstAccessMask(dstAccess);
+            barrier.setSrcQueueFamilyIndex(info.srcQueueFamily);
+            barrier.setDstQueueFamilyIndex(info.dstQueueFamily);
+            barrier.subresourceRange.setAspectMask(info.pImage->GetAspect());
+            barrier.subresourceRange.setBaseMipLevel(info.baseMipLevel);
+            barrier.subresourceRange.setLevelCount(info.mipLevelCount);
+            barrier.subresourceRange.setBaseArrayLayer(info.baseArrayLayer);
+            barrier.subresourceRange.setLayerCount(info.arrayLayerCount);
+            return barrier;
+        }
+
+        auto ToBufferBarrier(const BufferBarrierInfo& info) -> vk::BufferMemoryBarrier2
+        {
+            vk::BufferMemoryBarrier2 barrier{};
+            barrier.setBuffer(info.pBuffer->GetBuffer());
+            barrier.setOffset(info.offset);
+            barrier.setSize(info.size);
+            barrier.setSrcStageMask(info.srcStage);
+            barrier.setSrcAccessMask(info.srcAccess);
+            barrier.setDstStageMask(info.dstStage);
+            barrier.setDstAccessMask(info.dstAccess);
+            barrier.setSrcQueueFamilyIndex(info.srcQueueFamily);
+            barrier.setDstQueueFamilyIndex(info.dstQueueFamily);
+            return barrier;
+        }
+
+    } // namespace
+
+    void CommandBuffer::BeginRenderPass(const RenderPassInfo& info, bool secondaryContents)
     {
         uint32_t width = UINT32_MAX;
         uint32_t height = UINT32_MAX;
@@ -63,6 +186,8 @@ namespace VkMana
         renderingInfo.setColorAttachments(colorAttachments);
         if(hasDepthStencil)
             renderingInfo.setPDepthAttachment(&depthStencilAttachment); // #TODO: Stencil Attachment.
+        if(secondaryContents)
+            renderingInfo.setFlags(vk::RenderingFlagBits::eContentsSecondaryCommandBuffers);
 
         m_cmd.beginRendering(renderingInfo);
 
@@ -96,8 +221,27 @@ namespace VkMana
         }
     }
 
+    void CommandBuffer::ExecuteCommands(const std::vector<CmdBuffer>& secondaryCmds)
+    {
+        std::vector<vk::CommandBuffer> cmds(secondaryCmds.size());
+        for(auto i = 0u; i < secondaryCmds.size(); ++i)
+        {
+            cmds[i] = secondaryCmds[i]->GetCmd();
+            cmds[i].end();
+        }
+
+        m_cmd.executeCommands(cmds);
+
+        // Bound state is undefined after executing secondary command buffers.
+        m_pipeline = nullptr;
+        m_boundSets = {};
+    }
+
     void CommandBuffer::BindPipeline(Pipeline* pPipeline)
     {
+        if(pPipeline == m_pipeline)
+            return;
+
         m_cmd.bindPipeline(pPipeline->GetBindPoint(), pPipeline->GetPipeline());
         m_pipeline = pPipeline;
     }
@@ -128,7 +272,14 @@ namespace VkMana
         for(auto i = 0u; i < sets.size(); ++i)
             descSets[i] = sets[i]->GetSet();
 
-        m_cmd.bindDescriptorSets(m_pipeline->GetBindPoint(), m_pipeline->GetLayout()->GetLayout(), firstSet, descSets, dynamicOffsets);
+        const auto bindPoint = m_pipeline->GetBindPoint();
+        const auto layout = m_pipeline->GetLayout()->GetLayout();
+        auto& bound = m_boundSets[bindPoint == vk::PipelineBindPoint::eCompute ? 1 : 0];
+        if(bound.Layout == layout && bound.FirstSet == firstSet && bound.Sets == descSets && bound.DynamicOffsets == dynamicOffsets)
+            return;
+
+        m_cmd.bindDescriptorSets(bindPoint, layout, firstSet, descSets, dynamicOffsets);
+        bound = { layout, firstSet, std::move(descSets), dynamicOffsets };
     }
 
     void CommandBuffer::BindIndexBuffer(const Buffer* pBuffer, uint64_t offsetBytes, vk::IndexType indexType)
@@ -164,90 +315,34 @@ namespace VkMana
 
     void CommandBuffer::Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ) { m_cmd.dispatch(groupCountX, groupCountY, groupCountZ); }
 
-    void CommandBuffer::TransitionImage(const ImageTransitionInfo& info)
+    void CommandBuffer::TransitionImage(const ImageTransitionInfo& info) { PipelineBarrier({ info }, {}); }
+
+    void CommandBuffer::BufferBarrier(const BufferBarrierInfo& info) { PipelineBarrier({}, { info }); }
+
+    void CommandBuffer::PipelineBarrier(const std::vector<ImageTransitionInfo>& imageTransitions, const std::vector<BufferBarrierInfo>& bufferBarriers)
     {
-        vk::PipelineStageFlags2 srcStage = {};
-        vk::AccessFlags2 srcAccess = {};
-        switch(info.oldLayout)
+        if(imageTransitions.empty() && bufferBarriers.empty())
+            return;
+
+        std::vector<vk::ImageMemoryBarrier2> imageBarriers;
+        imageBarriers.reserve(imageTransitions.size());
+        for(const auto& info : imageTransitions)
         {
-        case vk::ImageLayout::eUndefined:
-            srcStage = vk::PipelineStageFlagBits2::eTopOfPipe;
-            srcAccess = vk::AccessFlagBits2::eNone;
-            break;
-        case vk::ImageLayout::eTransferSrcOptimal:
-            srcStage = vk::PipelineStageFlagBits2::eTransfer;
-            srcAccess = vk::AccessFlagBits2::eTransferRead;
-            break;
-        case vk::ImageLayout::eTransferDstOptimal:
-            srcStage = vk::PipelineStageFlagBits2::eTransfer;
-            srcAccess = vk::AccessFlagBits2::eTransferWrite;
-            break;
-        case vk::ImageLayout::eColorAttachmentOptimal:
-            srcStage = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
-            srcAccess = vk::AccessFlagBits2::eColorAttachmentWrite;
-            break;
-        case vk::ImageLayout::eDepthStencilAttachmentOptimal:
-            srcStage = vk::PipelineStageFlagBits2::eLateFragmentTests;
-            srcAccess = vk::AccessFlagBits2::eDepthStencilAttachmentWrite;
-            break;
-        case vk::ImageLayout::eShaderReadOnlyOptimal:
-            srcStage = vk::PipelineStageFlagBits2::eFragmentShader;
-            srcAccess = vk::AccessFlagBits2::eShaderRead;
-            break;
-        default:
-            assert(false);
-            break;
+            imageBarriers.push_back(ToImageBarrier(info));
+            TrackImageState(info);
         }
 
-        vk::PipelineStageFlags2 dstStage = {};
-        vk::AccessFlags2 dstAccess = {};
-        switch(info.newLayout)
+        std::vector<vk::BufferMemoryBarrier2> bufferMemoryBarriers;
+        bufferMemoryBarriers.reserve(bufferBarriers.size());
+        for(const auto& info : bufferBarriers)
         {
-        case vk::ImageLayout::eTransferSrcOptimal:
-            dstStage = vk::PipelineStageFlagBits2::eTransfer;
-            dstAccess = vk::AccessFlagBits2::eTransferRead;
-            break;
-        case vk::ImageLayout::eTransferDstOptimal:
-            dstStage = vk::PipelineStageFlagBits2::eTransfer;
-            dstAccess = vk::AccessFlagBits2::eTransferWrite;
-            break;
-        case vk::ImageLayout::eColorAttachmentOptimal:
-            dstStage = vk::PipelineStageFlagBits2::eColorAttachmentOutput;
-            dstAccess = vk::AccessFlagBits2::eColorAttachmentWrite;
-            break;
-        case vk::ImageLayout::eDepthStencilAttachmentOptimal:
-            dstStage = vk::PipelineStageFlagBits2::eEarlyFragmentTests;
-            dstAccess = vk::AccessFlagBits2::eDepthStencilAttachmentRead;
-            break;
-        case vk::ImageLayout::eShaderReadOnlyOptimal:
-            dstStage = vk::PipelineStageFlagBits2::eFragmentShader;
-            dstAccess = vk::AccessFlagBits2::eShaderRead;
-            break;
-        case vk::ImageLayout::ePresentSrcKHR:
-            dstStage = vk::PipelineStageFlagBits2::eBottomOfPipe;
-            dstAccess = vk::AccessFlagBits2::eNone;
-            break;
-        default:
-            assert(false);
-            break;
+            bufferMemoryBarriers.push_back(ToBufferBarrier(info));
+            TrackBufferState(info);
         }
 
-        vk::ImageMemoryBarrier2 barrier{};
-        barrier.setImage(info.pImage->GetImage());
-        barrier.setOldLayout(info.oldLayout);
-        barrier.setNewLayout(info.newLayout);
-        barrier.setDstStageMask(srcStage);
-        barrier.setDstAccessMask(srcAccess);
-        barrier.setSrcStageMask(dstStage);
-        barrier.setSrcAccessMask(dstAccess);
-        barrier.subresourceRange.setAspectMask(info.pImage->GetAspect());
-        barrier.subresourceRange.setBaseMipLevel(info.baseMipLevel);
-        barrier.subresourceRange.setLevelCount(info.mipLevelCount);
-        barrier.subresourceRange.setBaseArrayLayer(info.baseArrayLayer);
-        barrier.subresourceRange.setLayerCount(info.arrayLayerCount);
-
         vk::DependencyInfo depInfo{};
-        depInfo.setImageMemoryBarriers(barrier);
+        depInfo.setImageMemoryBarriers(imageBarriers);
+        depInfo.setBufferMemoryBarriers(bufferMemoryBarriers);
         m_cmd.pipelineBarrier2(depInfo);
     }
 
@@ -282,25 +377,151 @@ namespace VkMana
         m_cmd.copyBuffer2(copyInfo);
     }
 
+    void CommandBuffer::UpdateBuffer(const Buffer* pBuffer, uint64_t offset, uint64_t size, const void* pData)
+    {
+        if(size > MaxInlineBufferUpdateSize || size % 4 != 0 || offset % 4 != 0)
+        {
+            VM_ERR("Failed to update Buffer inline (size {} & offset {} must be multiples of 4, size at most {})", size, offset, MaxInlineBufferUpdateSize);
+            return;
+        }
+        m_cmd.updateBuffer(pBuffer->GetBuffer(), offset, size, pData);
+    }
+
+    void CommandBuffer::FillBuffer(const Buffer* pBuffer, uint32_t data, uint64_t offset, uint64_t size) { m_cmd.fillBuffer(pBuffer->GetBuffer(), offset, size, data); }
+
     void CommandBuffer::CopyBufferToImage(const BufferToImageCopyInfo& info)
+    {
+        const auto* pImage = info.pDstImage;
+
+        std::vector<vk::BufferImageCopy2> regions;
+        if(info.subresources.empty())
+        {
+            auto& region = regions.emplace_back();
+            region.setBufferOffset(info.srcOffset);
+            region.setImageExtent({ pImage->GetWidth(), pImage->GetHeight(), 1 });
+            region.imageSubresource.setAspectMask(pImage->GetAspect());
+            region.imageSubresource.setMipLevel(0);
+            region.imageSubresource.setBaseArrayLayer(0);
+            region.imageSubresource.setLayerCount(1);
+        }
+        for(const auto& subresource : info.subresources)
+        {
+            auto& region = regions.emplace_back();
+            region.setBufferOffset(info.srcOffset + subresource.offset);
+            region.setBufferRowLength(subresource.rowLength);
+            region.setBufferImageHeight(subresource.imageHeight);
+            region.setImageExtent({ std::max(pImage->GetWidth() >> subresource.mipLevel, 1u), std::max(pImage->GetHeight() >> subresource.mipLevel, 1u), 1 });
+            region.imageSubresource.setAspectMask(pImage->GetAspect());
+            region.imageSubresource.setMipLevel(subresource.mipLevel);
+            region.imageSubresource.setBaseArrayLayer(subresource.arrayLayer);
+            region.imageSubresource.setLayerCount(1);
+        }
+
+        vk::CopyBufferToImageInfo2 copyInfo{};
+        copyInfo.setSrcBuffer(info.pSrcBuffer->GetBuffer());
+        copyInfo.setDstImage(pImage->GetImage());
+        copyInfo.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+        copyInfo.setRegions(regions);
+
+        m_cmd.copyBufferToImage2(copyInfo);
+    }
+
+    void CommandBuffer::CopyImageToBuffer(const ImageToBufferCopyInfo& info)
     {
         vk::BufferImageCopy2 region{};
-        region.setBufferOffset(0);
+        region.setBufferOffset(info.dstOffset);
         region.setBufferRowLength(0);
         region.setBufferImageHeight(0);
-        region.setImageExtent({ info.pDstImage->GetWidth(), info.pDstImage->GetHeight(), info.pDstImage->GetDepthOrArrayLayers() });
-        region.imageSubresource.setAspectMask(info.pDstImage->GetAspect());
-        region.imageSubresource.setMipLevel(0);
-        region.imageSubresource.setBaseArrayLayer(0);
+        region.setImageExtent({ std::max(info.pSrcImage->GetWidth() >> info.mipLevel, 1u), std::max(info.pSrcImage->GetHeight() >> info.mipLevel, 1u), 1 });
+        region.imageSubresource.setAspectMask(info.pSrcImage->GetAspect());
+        region.imageSubresource.setMipLevel(info.mipLevel);
+        region.imageSubresource.setBaseArrayLayer(info.arrayLayer);
         region.imageSubresource.setLayerCount(1);
 
-        vk::CopyBufferToImageInfo2 copyInfo{};
-        copyInfo.setSrcBuffer(info.pSrcBuffer->GetBuffer());
-        copyInfo.setDstImage(info.pDstImage->GetImage());
-        copyInfo.setDstImageLayout(vk::ImageLayout::eTransferDstOptimal);
+        vk::CopyImageToBufferInfo2 copyInfo{};
+        copyInfo.setSrcImage(info.pSrcImage->GetImage());
+        copyInfo.setSrcImageLayout(vk::ImageLayout::eTransferSrcOptimal);
+        copyInfo.setDstBuffer(info.pDstBuffer->GetBuffer());
         copyInfo.setRegions(region);
 
-        m_cmd.copyBufferToImage2(copyInfo);
+        m_cmd.copyImageToBuffer2(copyInfo);
+
+        // Make the copy visible to the host once the submission has completed.
+        vk::MemoryBarrier2 barrier{};
+        barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer);
+        barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+        barrier.setDstStageMask(vk::PipelineStageFlagBits2::eHost);
+        barrier.setDstAccessMask(vk::AccessFlagBits2::eHostRead);
+
+        vk::DependencyInfo depInfo{};
+        depInfo.setMemoryBarriers(barrier);
+        m_cmd.pipelineBarrier2(depInfo);
+    }
+
+    auto CommandBuffer::ReadbackBuffer(const Buffer* pBuffer, uint64_t offset, uint64_t size) -> ReadbackHandle
+    {
+        const auto allocation = m_ctx->AllocateReadback(size);
+        if(allocation.pBuffer == nullptr)
+        {
+            VM_ERR("Failed to read back Buffer (Readback allocation failed)");
+            return nullptr;
+        }
+
+        BufferCopyInfo copyInfo{
+            .pSrcBuffer = pBuffer,
+            .pDstBuffer = allocation.pBuffer,
+            .size = size,
+            .srcOffset = offset,
+            .dstOffset = allocation.Offset,
+        };
+        CopyBuffer(copyInfo);
+
+        // Make the copy visible to the host once the submission has completed.
+        BufferBarrierInfo barrierInfo{
+            .pBuffer = allocation.pBuffer,
+            .srcStage = vk::PipelineStageFlagBits2::eTransfer,
+            .srcAccess = vk::AccessFlagBits2::eTransferWrite,
+            .dstStage = vk::PipelineStageFlagBits2::eHost,
+            .dstAccess = vk::AccessFlagBits2::eHostRead,
+            .offset = allocation.Offset,
+            .size = size,
+        };
+        BufferBarrier(barrierInfo);
+
+        auto readback = IntrusivePtr(new Readback(m_ctx, allocation, size));
+        m_readbacks.push_back(readback);
+        return readback;
+    }
+
+    auto CommandBuffer::ReadbackImage(const Image* pImage, uint32_t mipLevel, uint32_t arrayLayer) -> ReadbackHandle
+    {
+        const auto texelSize = FormatGetTexelSize(pImage->GetFormat());
+        if(texelSize == 0)
+        {
+            VM_ERR("Failed to read back Image (Unsupported format {})", vk::to_string(pImage->GetFormat()));
+            return nullptr;
+        }
+
+        const uint64_t size = uint64_t(std::max(pImage->GetWidth() >> mipLevel, 1u)) * std::max(pImage->GetHeight() >> mipLevel, 1u) * texelSize;
+        const auto allocation = m_ctx->AllocateReadback(size);
+        if(allocation.pBuffer == nullptr)
+        {
+            VM_ERR("Failed to read back Image (Readback allocation failed)");
+            return nullptr;
+        }
+
+        ImageToBufferCopyInfo copyInfo{
+            .pSrcImage = pImage,
+            .pDstBuffer = allocation.pBuffer,
+            .dstOffset = allocation.Offset,
+            .mipLevel = mipLevel,
+            .arrayLayer = arrayLayer,
+        };
+        CopyImageToBuffer(copyInfo);
+
+        auto readback = IntrusivePtr(new Readback(m_ctx, allocation, size));
+        m_readbacks.push_back(readback);
+        return readback;
     }
 
     void CommandBuffer::ResetQueryPool(const QueryPool* pQueryPool, uint32_t firstQuery, uint32_t queryCount)
@@ -328,9 +549,35 @@ namespace VkMana
         );
     }
 
-    CommandBuffer::CommandBuffer(Context* context, vk::CommandBuffer cmd)
+    bool CommandBuffer::IsOwnedByGraphicsAfter(uint32_t srcQueueFamily, uint32_t dstQueueFamily) const
+    {
+        const auto graphicsFamily = m_ctx->GetQueueFamily(QueueType::Graphics);
+        if(m_ctx->GetQueueFamily(m_queueType) != graphicsFamily)
+            return false; // Used by, or only released from, another queue family.
+        return srcQueueFamily == dstQueueFamily || dstQueueFamily == graphicsFamily;
+    }
+
+    void CommandBuffer::TrackImageState(const ImageTransitionInfo& info) const
+    {
+        const auto* pImage = info.pImage;
+        const auto levelCount = std::min(info.mipLevelCount, pImage->GetMipLevels() - std::min(info.baseMipLevel, pImage->GetMipLevels()));
+        const auto levels = uint32_t(((uint64_t(1) << levelCount) - 1) << info.baseMipLevel);
+        const bool allLayers = info.baseArrayLayer == 0 && info.arrayLayerCount >= pImage->GetDepthOrArrayLayers();
+        if(info.newLayout == vk::ImageLayout::eShaderReadOnlyOptimal && allLayers && IsOwnedByGraphicsAfter(info.srcQueueFamily, info.dstQueueFamily))
+            pImage->m_shaderReadMips.fetch_or(levels);
+        else
+            pImage->m_shaderReadMips.fetch_and(~levels);
+    }
+
+    void CommandBuffer::TrackBufferState(const BufferBarrierInfo& info) const
+    {
+        info.pBuffer->m_ownedByGraphics = IsOwnedByGraphicsAfter(info.srcQueueFamily, info.dstQueueFamily);
+    }
+
+    CommandBuffer::CommandBuffer(Context* context, vk::CommandBuffer cmd, QueueType queueType)
         : m_ctx(context)
         , m_cmd(cmd)
+        , m_queueType(queueType)
     {
     }
 
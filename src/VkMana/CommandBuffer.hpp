@@ -4,11 +4,10 @@
 #include "Image.hpp"
 #include "Pipeline.hpp"
 #include "QueryPool.hpp"
+#include "Readback.hpp"
 #include "RenderPass.hpp"
 #include "VulkanCommon.hpp"
 
-// #TODO: Batch pipeline barriers (image transitions)
-
 namespace VkMana
 {
     class Context;
@@ -38,6 +37,20 @@ namespace VkMana
         uint32_t mipLevelCount = 1;
         uint32_t baseArrayLayer = 0;
         uint32_t arrayLayerCount = 1;
+        uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED; // Set both queue families for a queue family ownership transfer.
+        uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED;
+    };
+    struct BufferBarrierInfo
+    {
+        const Buffer* pBuffer = nullptr;
+        vk::PipelineStageFlags2 srcStage = {};
+        vk::AccessFlags2 srcAccess = {};
+        vk::PipelineStageFlags2 dstStage = {};
+        vk::AccessFlags2 dstAccess = {};
+        uint64_t offset = 0;
+        uint64_t size = VK_WHOLE_SIZE;
+        uint32_t srcQueueFamily = VK_QUEUE_FAMILY_IGNORED; // Set both queue families for a queue family ownership transfer.
+        uint32_t dstQueueFamily = VK_QUEUE_FAMILY_IGNORED;
     };
     struct ImageBlitInfo
     {
@@ -72,6 +85,16 @@ namespace VkMana
     {
         const Buffer* pSrcBuffer = nullptr;
         const Image* pDstImage = nullptr;
+        uint64_t srcOffset = 0;
+        std::vector<ImageSubresourceData> subresources; // Offsets are relative to srcOffset. Empty = mip 0 of layer 0.
+    };
+    struct ImageToBufferCopyInfo
+    {
+        const Image* pSrcImage = nullptr; // Expected in TransferSrc.
+        const Buffer* pDstBuffer = nullptr;
+        uint64_t dstOffset = 0;
+        uint32_t mipLevel = 0;
+        uint32_t arrayLayer = 0;
     };
     struct QueryCopyInfo
     {
@@ -84,6 +107,11 @@ namespace VkMana
         vk::QueryResultFlags flags;
     };
 
+    constexpr uint64_t MaxInlineBufferUpdateSize = 65536; // vkCmdUpdateBuffer limit.
+
+    class CommandBuffer;
+    using CmdBuffer = IntrusivePtr<CommandBuffer>;
+
     class CommandBuffer : public IntrusivePtrEnabled<CommandBuffer>
     {
     public:
@@ -91,15 +119,17 @@ namespace VkMana
 
         /* State */
 
-        void BeginRenderPass(const RenderPassInfo& info);
+        void BeginRenderPass(const RenderPassInfo& info, bool secondaryContents = false); // Secondary: contents only from ExecuteCommands.
         void EndRenderPass();
 
-        void BindPipeline(Pipeline* pPipeline);
+        void ExecuteCommands(const std::vector<CmdBuffer>& secondaryCmds);
+
+        void BindPipeline(Pipeline* pPipeline); // Skipped if already bound.
         void SetViewport(float x, float y, float width, float height, float minDepth = 0.0f, float maxDepth = 1.0f);
         void SetScissor(int32_t x, int32_t y, uint32_t width, uint32_t height);
         void SetPushConstants(vk::ShaderStageFlags shaderStages, uint32_t offset, uint32_t size, const void* data);
 
-        void BindDescriptorSets(uint32_t firstSet, const std::vector<DescriptorSet*>& sets, const std::vector<uint32_t>& dynamicOffsets);
+        void BindDescriptorSets(uint32_t firstSet, const std::vector<DescriptorSet*>& sets, const std::vector<uint32_t>& dynamicOffsets); // Skipped if already bound.
 
         void BindIndexBuffer(const Buffer* pBuffer, uint64_t offsetBytes = 0, vk::IndexType indexType = vk::IndexType::eUint16);
         void BindVertexBuffers(uint32_t firstBinding, const std::vector<const Buffer*>& buffers, const std::vector<uint64_t>& offsets);
@@ -112,10 +142,27 @@ namespace VkMana
         void Dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
 
         void TransitionImage(const ImageTransitionInfo& info);
+        void BufferBarrier(const BufferBarrierInfo& info);
+        /* Records all transitions/barriers with a single vkCmdPipelineBarrier2. */
+        void PipelineBarrier(const std::vector<ImageTransitionInfo>& imageTransitions, const std::vector<BufferBarrierInfo>& bufferBarriers);
         void BlitImage(const ImageBlitInfo& info);
 
         void CopyBuffer(const BufferCopyInfo& info);
+        /**
+         * Data is recorded into the command buffer itself. Size & offset must be multiples of 4, size at most MaxInlineBufferUpdateSize.
+         * Must be recorded outside of a render pass. Buffer::Update picks between this & a staged copy.
+         */
+        void UpdateBuffer(const Buffer* pBuffer, uint64_t offset, uint64_t size, const void* pData);
+        void FillBuffer(const Buffer* pBuffer, uint32_t data, uint64_t offset = 0, uint64_t size = VK_WHOLE_SIZE); // Offset & size multiples of 4.
         void CopyBufferToImage(const BufferToImageCopyInfo& info);
+        void CopyImageToBuffer(const ImageToBufferCopyInfo& info);
+
+        /**
+         * Copy into the frame's readback ring. The handle becomes ready after this command buffer has been submitted & completed.
+         * Images are expected in TransferSrc. Data is tightly packed.
+         */
+        auto ReadbackBuffer(const Buffer* pBuffer, uint64_t offset, uint64_t size) -> ReadbackHandle;
+        auto ReadbackImage(const Image* pImage, uint32_t mipLevel = 0, uint32_t arrayLayer = 0) -> ReadbackHandle;
 
         void ResetQueryPool(const QueryPool* pQueryPool, uint32_t firstQuery, uint32_t queryCount);
         void BeginQuery(const QueryPool* pQueryPool, uint32_t queryIndex, vk::QueryControlFlags flags = {});
@@ -125,21 +172,38 @@ namespace VkMana
         /* Getters */
 
         auto GetCmd() const -> auto { return m_cmd; }
+        auto GetQueueType() const -> auto { return m_queueType; }
 
     private:
         friend class Context;
+        friend class UploadContext;
+
+        CommandBuffer(Context* context, vk::CommandBuffer cmd, QueueType queueType = QueueType::Graphics);
 
-        CommandBuffer(Context* context, vk::CommandBuffer cmd);
+        /* Resource state as of the last recorded barrier, so defragmentation only moves resources in a known state. */
+        bool IsOwnedByGraphicsAfter(uint32_t srcQueueFamily, uint32_t dstQueueFamily) const;
+        void TrackImageState(const ImageTransitionInfo& info) const;
+        void TrackBufferState(const BufferBarrierInfo& info) const;
 
     private:
         Context* m_ctx;
         vk::CommandBuffer m_cmd;
+        QueueType m_queueType;
 
         /* State */
 
         RenderPassInfo m_renderPass;
-        Pipeline* m_pipeline;
+        Pipeline* m_pipeline = nullptr;
+
+        struct BoundDescriptorSets
+        {
+            vk::PipelineLayout Layout; // Layouts are cached, so sets stay bound across pipelines sharing one.
+            uint32_t FirstSet = 0;
+            std::vector<vk::DescriptorSet> Sets;
+            std::vector<uint32_t> DynamicOffsets;
+        };
+        std::array<BoundDescriptorSets, 2> m_boundSets{}; // Graphics, Compute. Last bind only, used to skip redundant rebinds.
+        std::vector<ReadbackHandle> m_readbacks; // Handed to the frame on submission.
     };
-    using CmdBuffer = IntrusivePtr<CommandBuffer>;
 
 } // namespace VkMana
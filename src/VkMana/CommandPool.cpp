@@ -6,25 +6,64 @@ namespace VkMana
 {
     CommandPool::~CommandPool() { m_ctx->GetDevice().destroy(m_pool); }
 
-    auto CommandPool::RequestCmd() -> vk::CommandBuffer
+    auto CommandPool::RequestCmd(vk::CommandBufferLevel level) -> vk::CommandBuffer
     {
-        if(m_index >= m_cmds.size())
+        auto& cmdList = m_cmdLists[uint32_t(level)];
+        if(cmdList.Index >= cmdList.Cmds.size())
         {
             vk::CommandBufferAllocateInfo allocInfo{};
             allocInfo.setCommandPool(m_pool);
-            allocInfo.setLevel(vk::CommandBufferLevel::ePrimary);
-            allocInfo.setCommandBufferCount(1);
-            return m_ctx->GetDevice().allocateCommandBuffers(allocInfo)[0];
+            allocInfo.setLevel(level);
+            allocInfo.setCommandBufferCount(CommandBufferChunkSize);
+            auto cmds = m_ctx->GetDevice().allocateCommandBuffers(allocInfo);
+            cmdList.Cmds.insert(cmdList.Cmds.end(), cmds.begin(), cmds.end());
         }
 
-        auto cmd = m_cmds[m_index++];
+        auto cmd = cmdList.Cmds[cmdList.Index++];
+        cmdList.RecentHighWaterMark = std::max(cmdList.RecentHighWaterMark, cmdList.Index);
+        m_highWaterMark = std::max(m_highWaterMark, m_cmdLists[0].Index + m_cmdLists[1].Index);
         return cmd;
     }
 
     void CommandPool::ResetPool()
     {
         m_ctx->GetDevice().resetCommandPool(m_pool);
-        m_index = 0;
+        for(auto& cmdList : m_cmdLists)
+            cmdList.Index = 0;
+    }
+
+    void CommandPool::Trim()
+    {
+        for(auto& cmdList : m_cmdLists)
+        {
+            assert(cmdList.Index == 0);
+
+            // Keep whole chunks covering recent use.
+            const auto keepCount = (cmdList.RecentHighWaterMark + CommandBufferChunkSize - 1) / CommandBufferChunkSize * CommandBufferChunkSize;
+            if(keepCount < cmdList.Cmds.size())
+            {
+                const std::vector freeCmds(cmdList.Cmds.begin() + keepCount, cmdList.Cmds.end());
+                m_ctx->GetDevice().freeCommandBuffers(m_pool, freeCmds);
+                cmdList.Cmds.resize(keepCount);
+            }
+            cmdList.RecentHighWaterMark = 0;
+        }
+
+        m_ctx->GetDevice().trimCommandPool(m_pool, {});
+    }
+
+    bool CommandPool::HasRequestedCmds() const
+    {
+        return std::any_of(m_cmdLists.begin(), m_cmdLists.end(), [](const auto& cmdList) { return cmdList.Index != 0; });
+    }
+
+    auto CommandPool::GetStats() const -> CommandPoolStats
+    {
+        CommandPoolStats stats{};
+        for(const auto& cmdList : m_cmdLists)
+            stats.AllocatedCount += uint32_t(cmdList.Cmds.size());
+        stats.HighWaterMark = m_highWaterMark;
+        return stats;
     }
 
     CommandPool::CommandPool(Context* context, uint32_t queueFamilyIndex)
@@ -2,28 +2,55 @@
 
 #include "VulkanCommon.hpp"
 
+#include <array>
+
 namespace VkMana
 {
     class Context;
 
+    constexpr uint32_t CommandBufferChunkSize = 8; // Command buffers are allocated this many at a time.
+
+    struct CommandPoolStats
+    {
+        uint32_t AllocatedCount = 0; // Command buffers currently allocated from the pool(s).
+        uint32_t HighWaterMark = 0;  // Most command buffers (of both levels) requested between two resets.
+    };
+
     class CommandPool : public IntrusivePtrEnabled<CommandPool>
     {
     public:
         ~CommandPool();
 
-        auto RequestCmd() -> vk::CommandBuffer;
+        auto RequestCmd(vk::CommandBufferLevel level = vk::CommandBufferLevel::ePrimary) -> vk::CommandBuffer;
         void ResetPool();
 
+        /**
+         * Free command buffers beyond those needed since the last trim & return unused memory to the system.
+         * Use after a spike in requests. Only valid right after a reset.
+         */
+        void Trim();
+
+        bool HasRequestedCmds() const; // Any command buffers requested since the last reset.
+        auto GetStats() const -> CommandPoolStats;
+
     private:
         friend class Context;
+        friend class UploadContext;
 
         CommandPool(Context* context, uint32_t queueFamilyIndex);
 
     private:
         Context* m_ctx;
         vk::CommandPool m_pool;
-        std::vector<vk::CommandBuffer> m_cmds;
-        uint32_t m_index = 0;
+
+        struct CmdList
+        {
+            std::vector<vk::CommandBuffer> Cmds;
+            uint32_t Index = 0;
+            uint32_t RecentHighWaterMark = 0; // Since the last trim.
+        };
+        std::array<CmdList, 2> m_cmdLists; // Indexed by vk::CommandBufferLevel
+        uint32_t m_highWaterMark = 0;      // Most primary & secondary command buffers requested together between two resets, since creation.
     };
 
 } // namespace VkMana
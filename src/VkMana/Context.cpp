@@ -6,10 +6,109 @@
 #define VMA_STATIC_VULKAN_FUNCTIONS 0
 #include <vk_mem_alloc.h>
 
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+#include <tuple>
+
 VULKAN_HPP_DEFAULT_DISPATCH_LOADER_DYNAMIC_STORAGE
 
 namespace VkMana
 {
+    namespace
+    {
+        constexpr uint32_t MipMapGroupSize = 8;
+        constexpr uint32_t MaxMipsPerDispatch = 4; // log2(MipMapGroupSize) + 1
+
+        struct MipMapPushConstants
+        {
+            uint32_t SrcWidth;
+            uint32_t SrcHeight;
+            uint32_t LevelCount;
+        };
+
+        // Writes up to MaxMipsPerDispatch levels below the source level. Each 8x8 group reduces its tile further in shared memory.
+        constexpr auto MipMapShaderSource = R"(
+layout(local_size_x = 8, local_size_y = 8) in;
+layout(set = 0, binding = 0, MIP_FORMAT) uniform readonly image2D uSrc;
+layout(set = 0, binding = 1, MIP_FORMAT) uniform writeonly image2D uDst[4];
+layout(push_constant) uniform Constants
+{
+    uvec2 SrcSize;
+    uint LevelCount;
+} pc;
+
+shared vec4 sTile[8][8];
+
+vec4 Load(ivec2 coord) { return imageLoad(uSrc, min(coord, ivec2(pc.SrcSize) - 1)); }
+
+void Store(uint level, ivec2 coord, vec4 color)
+{
+    // Constant indices, so dynamic indexing of storage image arrays is not required.
+    switch(level)
+    {
+    case 0: imageStore(uDst[0], coord, color); break;
+    case 1: imageStore(uDst[1], coord, color); break;
+    case 2: imageStore(uDst[2], coord, color); break;
+    case 3: imageStore(uDst[3], coord, color); break;
+    }
+}
+
+void main()
+{
+    const ivec2 local = ivec2(gl_LocalInvocationID.xy);
+    const ivec2 dstCoord = ivec2(gl_GlobalInvocationID.xy);
+    const ivec2 srcCoord = dstCoord * 2;
+    vec4 color = 0.25 * (Load(srcCoord) + Load(srcCoord + ivec2(1, 0)) + Load(srcCoord + ivec2(0, 1)) + Load(srcCoord + ivec2(1, 1)));
+    if(all(lessThan(dstCoord, max(ivec2(pc.SrcSize) >> 1, ivec2(1)))))
+        Store(0, dstCoord, color);
+    sTile[local.y][local.x] = color;
+
+    for(uint i = 1; i < pc.LevelCount; ++i)
+    {
+        const int stride = 1 << i;
+        const int offset = stride >> 1;
+        const bool active = local.x % stride == 0 && local.y % stride == 0;
+
+        memoryBarrierShared();
+        barrier();
+        if(active)
+            color = 0.25 * (sTile[local.y][local.x] + sTile[local.y][local.x + offset] + sTile[local.y + offset][local.x] + sTile[local.y + offset][local.x + offset]);
+        memoryBarrierShared();
+        barrier();
+        if(active)
+        {
+            sTile[local.y][local.x] = color;
+            const ivec2 levelCoord = ivec2(gl_WorkGroupID.xy) * (8 >> i) + local / stride;
+            if(all(lessThan(levelCoord, max(ivec2(pc.SrcSize) >> (i + 1), ivec2(1)))))
+                Store(i, levelCoord, color);
+        }
+    }
+})";
+
+        // Formats the mip shader can load & store without shaderStorageImageReadWithoutFormat.
+        auto GetStorageFormatQualifier(vk::Format format) -> const char*
+        {
+            switch(format)
+            {
+            case vk::Format::eR8Unorm: return "r8";
+            case vk::Format::eR8G8Unorm: return "rg8";
+            case vk::Format::eR8G8B8A8Unorm: return "rgba8";
+            case vk::Format::eR8G8B8A8Snorm: return "rgba8_snorm";
+            case vk::Format::eA2B10G10R10UnormPack32: return "rgb10_a2";
+            case vk::Format::eB10G11R11UfloatPack32: return "r11f_g11f_b10f";
+            case vk::Format::eR16Sfloat: return "r16f";
+            case vk::Format::eR16G16Sfloat: return "rg16f";
+            case vk::Format::eR16G16B16A16Sfloat: return "rgba16f";
+            case vk::Format::eR32Sfloat: return "r32f";
+            case vk::Format::eR32G32Sfloat: return "rg32f";
+            case vk::Format::eR32G32B32A32Sfloat: return "rgba32f";
+            default: return nullptr;
+            }
+        }
+
+    } // namespace
+
     auto Context::New() -> IntrusivePtr<Context> { return IntrusivePtr(new Context); }
 
     Context::~Context()
@@ -19,11 +118,41 @@ namespace VkMana
 
         if(m_device)
         {
+            if(m_defrag.PassActive)
+                EndDefragmentationPass();
+            if(m_defrag.Context != VK_NULL_HANDLE)
+                EndDefragmentation();
+
             m_linearSampler = nullptr;
             m_nearestSampler = nullptr;
-
+            m_fullscreenQuadPipeline = nullptr;
+            m_singleImageSetLayout = nullptr;
+            m_mipMapPipelines.clear();
+            m_mipMapPipelineLayout = nullptr;
+            m_mipMapSetLayout = nullptr;
+            m_pipelineLayoutCache.clear();
+            m_setLayoutCache.clear();
+
+            m_pendingOwnershipTransfers.clear();
+            m_transientBuffer = nullptr;
+
+            // Release resources owned by frames while every frame's garbage bin is still alive.
+            // Outstanding readbacks keep their data, the GPU is idle.
+            std::unique_lock stagingLock(m_stagingMutex);
+            for(auto& frame : m_frames)
+            {
+                ResolveReadbacks(frame);
+                frame.Staging = nullptr;
+                frame.Readback = nullptr;
+            }
+            stagingLock.unlock();
             m_frames.clear();
 
+            for(auto& queue : m_queues)
+            {
+                if(queue.TimelineSemaphore)
+                    m_device.destroy(queue.TimelineSemaphore);
+            }
             m_device.destroy(m_descriptorPool);
 
             if(m_allocator)
@@ -37,15 +166,16 @@ namespace VkMana
         }
     }
 
-    bool Context::Init()
+    bool Context::Init(const ContextCreateInfo& info)
     {
         VULKAN_HPP_DEFAULT_DISPATCHER.init();
 
-        if(!InitInstance(m_instance))
+        m_headless = info.headless;
+        if(!InitInstance(m_instance, m_headless))
             return false;
-        if(!SelectGPU(m_gpu, m_instance))
+        if(!SelectGPU(m_gpu, m_gpuInfo, m_instance, info))
             return false;
-        if(!InitDevice(m_device, m_queueInfo, m_gpu))
+        if(!InitDevice(m_device, m_queues, m_queueMap, m_gpu, m_gpuInfo, m_headless))
             return false;
 
         vma::VulkanFunctions vulkanFunctions{};
@@ -57,9 +187,17 @@ namespace VkMana
         allocInfo.setDevice(m_device);
         allocInfo.setVulkanApiVersion(VK_API_VERSION_1_3);
         allocInfo.setPVulkanFunctions(&vulkanFunctions);
+        if(m_gpuInfo.SupportsMemoryBudget)
+            allocInfo.setFlags(vma::AllocatorCreateFlagBits::eExtMemoryBudget);
         m_allocator = vma::createAllocator(allocInfo);
 
-        if(!SetupFrames())
+        for(auto& queue : m_queues)
+        {
+            if(queue.Queue)
+                queue.TimelineSemaphore = CreateTimelineSemaphore();
+        }
+
+        if(!SetupFrames(info.framesInFlight))
             return false;
 
         std::vector<vk::DescriptorPoolSize> poolSizes{
@@ -72,9 +210,25 @@ namespace VkMana
         vk::DescriptorPoolCreateInfo poolInfo{};
         poolInfo.setPoolSizes(poolSizes);
         poolInfo.setMaxSets(500);
-        poolInfo.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind);
+        poolInfo.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind | vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet);
         m_descriptorPool = m_device.createDescriptorPool(poolInfo);
 
+        const auto limits = m_gpu.getProperties().limits;
+        m_transientAlignment = std::max(limits.minUniformBufferOffsetAlignment, limits.minStorageBufferOffsetAlignment);
+        m_transientFrameSize = (info.transientBufferSize + m_transientAlignment - 1) / m_transientAlignment * m_transientAlignment;
+        m_transientBuffer = CreateBuffer({
+            .size = m_transientFrameSize * m_frames.size(),
+            .usage = vk::BufferUsageFlagBits::eUniformBuffer | vk::BufferUsageFlagBits::eStorageBuffer,
+            .memUsage = vma::MemoryUsage::eAutoPreferDevice,
+            .allocFlags = vma::AllocationCreateFlagBits::eHostAccessSequentialWrite | vma::AllocationCreateFlagBits::eMapped,
+        });
+        if(m_transientBuffer == nullptr)
+        {
+            VM_ERR("Failed to create transient buffer");
+            return false;
+        }
+        m_transientBuffer->SetDebugName("Context Transient");
+
         m_nearestSampler = CreateSampler({
             .minFilter = vk::Filter::eNearest,
             .magFilter = vk::Filter::eNearest,
@@ -138,76 +292,270 @@ void main()
             m_fullscreenQuadPipeline = CreateGraphicsPipeline(fullscreenQuadPipelineInfo);
         }
 
+        {
+            // Pipelines are compiled on first use, per storage format.
+            m_mipMapSetLayout = CreateSetLayout({
+                { 0, vk::DescriptorType::eStorageImage,                  1, vk::ShaderStageFlagBits::eCompute },
+                { 1, vk::DescriptorType::eStorageImage, MaxMipsPerDispatch, vk::ShaderStageFlagBits::eCompute },
+            });
+            m_mipMapPipelineLayout = CreatePipelineLayout({
+                .PushConstantRange = { vk::ShaderStageFlagBits::eCompute, 0, sizeof(MipMapPushConstants) },
+                .SetLayouts = { m_mipMapSetLayout.Get() },
+            });
+        }
+
         return true;
     }
 
     void Context::BeginFrame()
     {
-        m_frameIndex = (m_frameIndex + 1) % m_frames.size();
-        auto& frame = GetFrame();
+        const auto frameIndex = (m_frameIndex + 1) % m_frames.size();
+        auto& frame = m_frames[frameIndex];
 
-        if(!frame.FrameFences.empty())
+        for(auto i = 0u; i < frame.TimelineValues.size(); ++i)
+            WaitForTimelineValue(QueueType(i), frame.TimelineValues[i]);
+
+        for(auto& threadCmdPools : frame.CmdPools)
         {
-            UNUSED(m_device.waitForFences(frame.FrameFences, true, UINT64_MAX));
-            m_device.resetFences(frame.FrameFences);
-            frame.FrameFences.clear();
+            // Drop pools of threads that recorded nothing during the last use of this frame (e.g. short-lived workers).
+            std::erase_if(threadCmdPools, [](const auto& pair) { return !pair.second->HasRequestedCmds(); });
+            for(auto& [threadId, cmdPool] : threadCmdPools)
+            {
+                cmdPool->ResetPool();
+                if(frame.TrimCmdPools)
+                    cmdPool->Trim();
+            }
         }
-
-        frame.CmdPool->ResetPool();
+        frame.TrimCmdPools = false;
         frame.DescriptorAllocator->ResetAllocator();
+        {
+            std::lock_guard transientLock(m_transientMutex);
+            frame.TransientOffset = 0;
+        }
+        {
+            std::lock_guard stagingLock(m_stagingMutex);
+            frame.Staging->Reset();
+            ResolveReadbacks(frame);
+            frame.Readback->Reset();
+        }
+
+        std::unique_lock lock(m_garbageMutex);
+        {
+            // Transient writes are also flushed by worker threads submitting to an aliased queue.
+            std::lock_guard transientLock(m_transientMutex);
+            m_frameIndex = frameIndex;
+        }
+        ++m_frameNumber;
         frame.Garbage->EmptyBins();
+
+        m_allocator.setCurrentFrameIndex(uint32_t(m_frameNumber)); // Refreshes the memory budget.
+        lock.unlock();
+
+        std::lock_guard defragLock(m_defragMutex);
+        StepDefragmentation();
     }
 
     void Context::EndFrame()
     {
-        auto& frame = GetFrame();
+        // Every submission signals its queue's timeline & records the value in the frame,
+        // so the frame is complete once its last submission on each queue has.
+        FlushQueues();
+    }
+
+    auto Context::RequestCmd(QueueType queueType) -> CmdBuffer
+    {
+        auto cmd = GetThreadCmdPool(queueType)->RequestCmd();
+        vk::CommandBufferBeginInfo beginInfo{};
+        cmd.begin(beginInfo);
+        return IntrusivePtr(new CommandBuffer(this, cmd, queueType));
+    }
 
-        const auto signalSemaphore = m_device.createSemaphore({});
-        const auto fence = m_device.createFence({});
+    auto Context::RequestSecondaryCmd(const RenderPassInfo& renderPass) -> CmdBuffer
+    {
+        std::vector<vk::Format> colorFormats;
+        vk::Format depthFormat = vk::Format::eUndefined;
+        vk::Format stencilFormat = vk::Format::eUndefined;
+        for(const auto& target : renderPass.targets)
+        {
+            const auto format = target.pImage->GetImage()->GetFormat();
+            if(target.isDepthStencil)
+            {
+                depthFormat = FormatHasDepth(format) ? format : vk::Format::eUndefined;
+                stencilFormat = FormatHasStencil(format) ? format : vk::Format::eUndefined;
+            }
+            else
+            {
+                colorFormats.push_back(format);
+            }
+        }
 
-        vk::SubmitInfo submitInfo{};
-        submitInfo.setSignalSemaphores(signalSemaphore);
-        m_queueInfo.GraphicsQueue.submit(submitInfo, fence);
+        vk::CommandBufferInheritanceRenderingInfo renderingInfo{};
+        renderingInfo.setColorAttachmentFormats(colorFormats);
+        renderingInfo.setDepthAttachmentFormat(depthFormat);
+        renderingInfo.setStencilAttachmentFormat(stencilFormat);
+        renderingInfo.setRasterizationSamples(vk::SampleCountFlagBits::e1);
 
-        m_presentWaitSemaphores.push_back(signalSemaphore);
-        frame.Garbage->Bin(signalSemaphore);
+        vk::CommandBufferInheritanceInfo inheritanceInfo{};
+        inheritanceInfo.setPNext(&renderingInfo);
 
-        frame.FrameFences.push_back(fence);
-        frame.Garbage->Bin(fence);
+        auto cmd = GetThreadCmdPool(QueueType::Graphics)->RequestCmd(vk::CommandBufferLevel::eSecondary);
+        vk::CommandBufferBeginInfo beginInfo{};
+        beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eRenderPassContinue | vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+        beginInfo.setPInheritanceInfo(&inheritanceInfo);
+        cmd.begin(beginInfo);
+        return IntrusivePtr(new CommandBuffer(this, cmd, QueueType::Graphics));
     }
 
-    auto Context::RequestCmd() -> CmdBuffer
+    void Context::TrimCommandPools()
     {
-        auto cmd = GetFrame().CmdPool->RequestCmd();
-        vk::CommandBufferBeginInfo beginInfo{};
-        cmd.begin(beginInfo);
-        return IntrusivePtr(new CommandBuffer(this, cmd));
+        for(auto& frame : m_frames)
+            frame.TrimCmdPools = true;
     }
 
-    void Context::Submit(CmdBuffer cmd)
+    auto Context::GetCommandPoolStats() -> CommandPoolStats
     {
-        auto commandBuffer = cmd->GetCmd();
-        commandBuffer.end();
+        std::lock_guard lock(m_cmdPoolMutex);
 
-        vk::SubmitInfo submitInfo{};
-        submitInfo.setWaitSemaphores(m_submitWaitSemaphores);
-        submitInfo.setWaitDstStageMask(m_submitWaitStageMasks);
-        submitInfo.setCommandBuffers(commandBuffer);
-        m_queueInfo.GraphicsQueue.submit(submitInfo);
+        CommandPoolStats stats{};
+        for(const auto& frame : m_frames)
+        {
+            for(const auto& threadCmdPools : frame.CmdPools)
+            {
+                for(const auto& [threadId, cmdPool] : threadCmdPools)
+                {
+                    const auto poolStats = cmdPool->GetStats();
+                    stats.AllocatedCount += poolStats.AllocatedCount;
+                    stats.HighWaterMark = std::max(stats.HighWaterMark, poolStats.HighWaterMark);
+                }
+            }
+        }
+        return stats;
+    }
 
-        m_submitWaitSemaphores.clear();
-        m_submitWaitStageMasks.clear();
+    auto Context::Submit(CmdBuffer cmd, const std::vector<SyncPoint>& waitPoints, vk::PipelineStageFlags2 waitStages) -> SyncPoint
+    {
+        return Submit(std::vector{ std::move(cmd) }, waitPoints, waitStages);
     }
 
-    void Context::SubmitStaging(CmdBuffer cmd)
+    auto Context::Submit(const std::vector<CmdBuffer>& cmds, const std::vector<SyncPoint>& waitPoints, vk::PipelineStageFlags2 waitStages) -> SyncPoint
     {
-        Submit(std::move(cmd));
+        assert(!cmds.empty());
+        const auto queueType = cmds.front()->GetQueueType();
+
+        std::vector<QueueOwnershipTransfer> ownershipTransfers;
+        if(queueType == QueueType::Graphics)
+        {
+            std::lock_guard lock(m_ownershipMutex);
+            ownershipTransfers.swap(m_pendingOwnershipTransfers);
+        }
+
+        std::vector<vk::CommandBufferSubmitInfo> cmdInfos;
+        std::vector<vk::SemaphoreSubmitInfo> waitInfos;
+        for(const auto& waitPoint : waitPoints)
+        {
+            if(waitPoint.Value == 0)
+                continue;
+
+            // The submission being waited on must reach its queue first. Submissions on the same queue are already ordered.
+            if(&GetQueueInfo(waitPoint.Queue) != &GetQueueInfo(queueType))
+                Flush(waitPoint.Queue);
+
+            auto& waitInfo = waitInfos.emplace_back();
+            waitInfo.setSemaphore(GetTimelineSemaphore(waitPoint.Queue));
+            waitInfo.setValue(waitPoint.Value);
+            waitInfo.setStageMask(waitStages);
+        }
+
+        if(!ownershipTransfers.empty())
+        {
+            // Acquire resources released by the transfer queue before any work that may use them.
+            auto acquireCmd = RequestCmd();
+            uint64_t transferValue = 0;
+            for(const auto& transfer : ownershipTransfers)
+            {
+                RecordOwnershipAcquire(acquireCmd, transfer);
+                transferValue = std::max(transferValue, transfer.TransferValue);
+            }
+            acquireCmd->GetCmd().end();
+            cmdInfos.emplace_back().setCommandBuffer(acquireCmd->GetCmd());
+
+            auto& waitInfo = waitInfos.emplace_back();
+            waitInfo.setSemaphore(GetTimelineSemaphore(QueueType::Transfer));
+            waitInfo.setValue(transferValue);
+            waitInfo.setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+        }
+
+        for(const auto& cmd : cmds)
+        {
+            assert(cmd->GetQueueType() == queueType);
+            auto commandBuffer = cmd->GetCmd();
+            commandBuffer.end();
+            cmdInfos.emplace_back().setCommandBuffer(commandBuffer);
+        }
+
+        const auto signalValue = EnqueueSubmission(queueType, std::move(waitInfos), std::move(cmdInfos));
+        {
+            auto lock = LockQueue(queueType);
+            auto& frameValue = GetFrame().TimelineValues[uint8_t(queueType)];
+            frameValue = std::max(frameValue, signalValue);
+        }
+        {
+            std::lock_guard stagingLock(m_stagingMutex);
+            for(auto cmd : cmds)
+            {
+                for(auto& readback : cmd->m_readbacks)
+                {
+                    std::lock_guard readbackLock(readback->m_mutex);
+                    readback->m_syncPoint = { queueType, signalValue };
+                    readback->m_submitted = true;
+                    GetFrame().Readbacks.push_back(std::move(readback));
+                }
+                cmd->m_readbacks.clear();
+            }
+        }
+        return { queueType, signalValue };
+    }
+
+    void Context::Flush(QueueType queueType)
+    {
+        auto& queue = GetQueueInfo(queueType);
+        auto lock = LockQueue(queueType);
+        if(queue.PendingSubmissions.empty())
+            return;
+
+        FlushTransientWrites();
+
+        std::vector<vk::SemaphoreSubmitInfo> signalInfos(queue.PendingSubmissions.size());
+        std::vector<vk::SubmitInfo2> submitInfos(queue.PendingSubmissions.size());
+        for(auto i = 0u; i < queue.PendingSubmissions.size(); ++i)
+        {
+            const auto& submission = queue.PendingSubmissions[i];
+
+            signalInfos[i].setSemaphore(queue.TimelineSemaphore);
+            signalInfos[i].setValue(submission.SignalValue);
+            signalInfos[i].setStageMask(vk::PipelineStageFlagBits2::eAllCommands);
+
+            submitInfos[i].setWaitSemaphoreInfos(submission.WaitInfos);
+            submitInfos[i].setCommandBufferInfos(submission.CmdInfos);
+            submitInfos[i].setSignalSemaphoreInfos(signalInfos[i]);
+        }
+        queue.Queue.submit2(submitInfos);
+        queue.PendingSubmissions.clear();
+    }
 
-        auto fence = m_device.createFence({});
-        m_queueInfo.GraphicsQueue.submit({}, fence);
+    void Context::FlushQueues()
+    {
+        for(auto i = 0u; i < m_queues.size(); ++i)
+        {
+            if(HasDedicatedQueue(QueueType(i)))
+                Flush(QueueType(i));
+        }
+    }
 
-        GetFrame().FrameFences.push_back(fence);
-        GetFrame().Garbage->Bin(fence);
+    void Context::SubmitStaging(CmdBuffer cmd)
+    {
+        // Staging work is retired with the frame via the timeline, no extra fence is needed.
+        Submit(std::move(cmd));
     }
 
     void Context::DrawFullScreenQuad(CmdBuffer& cmd, ImageHandle& image)
@@ -220,8 +568,240 @@ void main()
         cmd->Draw(3, 0);
     }
 
+    void Context::GenerateMipMaps(CmdBuffer& cmd, const Image* pImage) { GenerateMipMaps(cmd, std::vector{ pImage }); }
+
+    void Context::GenerateMipMaps(CmdBuffer& cmd, const std::vector<const Image*>& images)
+    {
+        std::vector<const Image*> blitImages;
+        std::vector<const Image*> computeImages;
+        for(const auto* pImage : images)
+        {
+            if((pImage->GetFlags() & ImageCreateFlags_GenMipMapsCompute) && GetMipMapPipeline(pImage->GetFormat()) != nullptr)
+                computeImages.push_back(pImage);
+            else
+                blitImages.push_back(pImage);
+        }
+
+        if(!blitImages.empty())
+            GenerateMipMapsBlit(cmd, blitImages);
+        if(!computeImages.empty())
+            GenerateMipMapsCompute(cmd, computeImages);
+    }
+
+    bool Context::SupportsComputeMipMaps(vk::Format format) const
+    {
+        if(GetStorageFormatQualifier(format) == nullptr)
+            return false;
+
+        const auto formatProps = m_gpu.getFormatProperties(format);
+        return bool(formatProps.optimalTilingFeatures & vk::FormatFeatureFlagBits::eStorageImage);
+    }
+
+    void Context::GenerateMipMapsBlit(CmdBuffer& cmd, const std::vector<const Image*>& images)
+    {
+        uint32_t maxMipLevels = 0;
+        for(const auto* pImage : images)
+            maxMipLevels = std::max(maxMipLevels, pImage->GetMipLevels());
+
+        // Each level's src -> ShaderReadOnly transition is merged into the barrier of the next level.
+        std::vector<ImageTransitionInfo> transitions;
+        for(auto i = 1u; i < maxMipLevels; ++i)
+        {
+            // Transition src mips to TransferSrc
+            for(const auto* pImage : images)
+            {
+                if(i < pImage->GetMipLevels())
+                {
+                    transitions.push_back({
+                        .pImage = pImage,
+                        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                        .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+                        .baseMipLevel = i - 1,
+                        .mipLevelCount = 1,
+                    });
+                }
+            }
+            cmd->PipelineBarrier(transitions, {});
+            transitions.clear();
+
+            // Blit src mips to dst mips
+            for(const auto* pImage : images)
+            {
+                if(i >= pImage->GetMipLevels())
+                    continue;
+
+                const auto srcWidth = std::max(int32_t(pImage->GetWidth() >> (i - 1)), 1);
+                const auto srcHeight = std::max(int32_t(pImage->GetHeight() >> (i - 1)), 1);
+                ImageBlitInfo blitInfo{
+                    .pSrcImage = pImage,
+                    .srcRectEnd = { srcWidth, srcHeight, 1, },
+                    .srcMipLevel = i - 1,
+                    .pDstImage = pImage,
+                    .dstRectEnd = { srcWidth > 1 ? srcWidth / 2 : 1, srcHeight > 1 ? srcHeight / 2 : 1, 1, },
+                    .dstMipLevel = i,
+                    .filter = GetMipMapBlitFilter(pImage->GetFormat()),
+                };
+                cmd->BlitImage(blitInfo);
+
+                // Transition src mip to ShaderReadOnly
+                transitions.push_back({
+                    .pImage = pImage,
+                    .oldLayout = vk::ImageLayout::eTransferSrcOptimal,
+                    .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                    .baseMipLevel = i - 1,
+                    .mipLevelCount = 1,
+                });
+            }
+        }
+
+        // Transition last mip level to ShaderReadOnly
+        for(const auto* pImage : images)
+        {
+            transitions.push_back({
+                .pImage = pImage,
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                .baseMipLevel = pImage->GetMipLevels() - 1,
+                .mipLevelCount = 1,
+            });
+        }
+        cmd->PipelineBarrier(transitions, {});
+    }
+
+    void Context::GenerateMipMapsCompute(CmdBuffer& cmd, const std::vector<const Image*>& images)
+    {
+        // All levels stay in General while they are read & written as storage images.
+        uint32_t maxMipLevels = 0;
+        std::vector<ImageTransitionInfo> transitions;
+        for(const auto* pImage : images)
+        {
+            maxMipLevels = std::max(maxMipLevels, pImage->GetMipLevels());
+            transitions.push_back({
+                .pImage = pImage,
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eGeneral,
+                .mipLevelCount = pImage->GetMipLevels(),
+            });
+        }
+        cmd->PipelineBarrier(transitions, {});
+        transitions.clear();
+
+        for(auto srcLevel = 0u; srcLevel + 1 < maxMipLevels; srcLevel += MaxMipsPerDispatch)
+        {
+            if(srcLevel > 0)
+            {
+                // The source level was the last level written by the previous dispatch.
+                for(const auto* pImage : images)
+                {
+                    if(srcLevel + 1 < pImage->GetMipLevels())
+                        transitions.push_back({ .pImage = pImage, .oldLayout = vk::ImageLayout::eGeneral, .newLayout = vk::ImageLayout::eGeneral, .baseMipLevel = srcLevel });
+                }
+                cmd->PipelineBarrier(transitions, {});
+                transitions.clear();
+            }
+
+            for(const auto* pImage : images)
+            {
+                if(srcLevel + 1 >= pImage->GetMipLevels())
+                    continue;
+
+                const auto levelCount = std::min(MaxMipsPerDispatch, pImage->GetMipLevels() - 1 - srcLevel);
+
+                // Views are binned with the frame, after the dispatch has completed.
+                auto srcView = CreateImageView(pImage, { .targetImage = pImage, .baseMipLevel = srcLevel });
+                std::vector<ImageViewHandle> dstViews;
+                std::vector<const ImageView*> dstViewPtrs;
+                for(auto i = 0u; i < MaxMipsPerDispatch; ++i)
+                {
+                    // Unused array elements repeat the last level, they are never written.
+                    if(i < levelCount)
+                        dstViews.push_back(CreateImageView(pImage, { .targetImage = pImage, .baseMipLevel = srcLevel + 1 + i }));
+                    dstViewPtrs.push_back(dstViews.back().Get());
+                }
+
+                auto set = RequestDescriptorSet(m_mipMapSetLayout.Get());
+                set->WriteStorageArray(0, 0, { srcView.Get() });
+                set->WriteStorageArray(1, 0, dstViewPtrs);
+
+                const MipMapPushConstants constants{
+                    .SrcWidth = std::max(pImage->GetWidth() >> srcLevel, 1u),
+                    .SrcHeight = std::max(pImage->GetHeight() >> srcLevel, 1u),
+                    .LevelCount = levelCount,
+                };
+                const auto dstWidth = std::max(constants.SrcWidth >> 1, 1u);
+                const auto dstHeight = std::max(constants.SrcHeight >> 1, 1u);
+
+                cmd->BindPipeline(GetMipMapPipeline(pImage->GetFormat()));
+                cmd->BindDescriptorSets(0, { set.Get() }, {});
+                cmd->SetPushConstants(vk::ShaderStageFlagBits::eCompute, 0, sizeof(constants), &constants);
+                cmd->Dispatch((dstWidth + MipMapGroupSize - 1) / MipMapGroupSize, (dstHeight + MipMapGroupSize - 1) / MipMapGroupSize, 1);
+            }
+        }
+
+        for(const auto* pImage : images)
+        {
+            transitions.push_back({
+                .pImage = pImage,
+                .oldLayout = vk::ImageLayout::eGeneral,
+                .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                .mipLevelCount = pImage->GetMipLevels(),
+            });
+        }
+        cmd->PipelineBarrier(transitions, {});
+    }
+
+    auto Context::GetMipMapBlitFilter(vk::Format format) const -> vk::Filter
+    {
+        const auto formatProps = m_gpu.getFormatProperties(format);
+        if(formatProps.optimalTilingFeatures & vk::FormatFeatureFlagBits::eSampledImageFilterLinear)
+            return vk::Filter::eLinear;
+        return vk::Filter::eNearest;
+    }
+
+    auto Context::GetMipMapPipeline(vk::Format format) -> Pipeline*
+    {
+        std::lock_guard lock(m_mipMapPipelineMutex);
+
+        auto it = m_mipMapPipelines.find(format);
+        if(it != m_mipMapPipelines.end())
+            return it->second.Get();
+
+        auto& pipeline = m_mipMapPipelines[format]; // Stays null if compilation fails, so it is not retried.
+        const auto* formatQualifier = GetStorageFormatQualifier(format);
+        if(formatQualifier == nullptr)
+            return nullptr;
+
+        const auto source = std::string("#version 460 core\n#define MIP_FORMAT ") + formatQualifier + "\n" + MipMapShaderSource;
+
+        ShaderCompileInfo shaderInfo{};
+        shaderInfo.srcLanguage = SourceLanguage::GLSL;
+        shaderInfo.pSrcStringStr = source.c_str();
+        shaderInfo.stage = vk::ShaderStageFlagBits::eCompute;
+        shaderInfo.debug = false;
+        auto csByteCode = CompileShader(shaderInfo);
+        if(!csByteCode)
+        {
+            VM_ERR("Failed to compile mip map compute shader ({})", formatQualifier);
+            return nullptr;
+        }
+
+        ComputePipelineCreateInfo pipelineInfo{};
+        pipelineInfo.cs = {
+            { csByteCode->data(), uint32_t(csByteCode->size()) }
+        };
+        pipelineInfo.pPipelineLayout = m_mipMapPipelineLayout;
+        pipeline = CreateComputePipeline(pipelineInfo);
+        return pipeline.Get();
+    }
+
     auto Context::CreateSurface(void* windowHandle) -> vk::SurfaceKHR
     {
+        if(m_headless)
+        {
+            VM_ERR("Failed to create Surface (Context is headless)");
+            return nullptr;
+        }
+
 #if defined(VK_USE_PLATFORM_WIN32_KHR)
         vk::Win32SurfaceCreateInfoKHR surfaceInfo{};
         surfaceInfo.hinstance = GetModuleHandle(nullptr);
@@ -234,17 +814,71 @@ void main()
 
     auto Context::CreateSwapChain(vk::SurfaceKHR surface, uint32_t width, uint32_t height) -> SwapChainHandle
     {
+        if(m_headless)
+        {
+            VM_ERR("Failed to create SwapChain (Context is headless)");
+            return nullptr;
+        }
+
         return SwapChain::New(this, surface, width, height);
     }
 
+    auto Context::CreateOffscreenTarget(uint32_t width, uint32_t height, vk::Format format) -> OffscreenTargetHandle
+    {
+        return OffscreenTarget::New(this, width, height, format);
+    }
+
     auto Context::RequestDescriptorSet(const SetLayout* layout) -> DescriptorSetHandle
     {
         auto& frame = GetFrame();
 
+        std::unique_lock lock(m_descriptorAllocatorMutex);
         auto descriptorSet = frame.DescriptorAllocator->Allocate(layout->GetLayout());
+        lock.unlock();
+        if(!descriptorSet)
+            return nullptr;
+
         return IntrusivePtr(new DescriptorSet(this, descriptorSet));
     }
 
+    auto Context::CreateDescriptorSet(const SetLayout* layout) -> DescriptorSetHandle
+    {
+        const auto setLayout = layout->GetLayout();
+        vk::DescriptorSetAllocateInfo allocInfo{};
+        allocInfo.setDescriptorPool(m_descriptorPool);
+        allocInfo.setSetLayouts(setLayout);
+
+        std::lock_guard lock(m_descriptorPoolMutex);
+        vk::DescriptorSet descriptorSet;
+        if(m_device.allocateDescriptorSets(&allocInfo, &descriptorSet) != vk::Result::eSuccess)
+        {
+            VM_ERR("Failed to create DescriptorSet (Pool exhausted)");
+            return nullptr;
+        }
+        auto set = IntrusivePtr(new DescriptorSet(this, descriptorSet, true, setLayout));
+        m_staticSets.push_back(set.Get()); // Re-written by defragmentation.
+        return set;
+    }
+
+    auto Context::AllocateTransient(uint64_t size, uint64_t alignment) -> TransientAllocation
+    {
+        if(alignment == 0)
+            alignment = m_transientAlignment;
+
+        std::lock_guard lock(m_transientMutex);
+        auto& frame = GetFrame();
+        const auto offset = (frame.TransientOffset + alignment - 1) / alignment * alignment;
+        if(offset + size > m_transientFrameSize)
+        {
+            VM_ERR("Failed to allocate transient data ({} bytes). Increase ContextCreateInfo::transientBufferSize", size);
+            return {};
+        }
+        frame.TransientOffset = offset + size;
+
+        const auto bufferOffset = m_transientFrameSize * m_frameIndex + offset;
+        return { m_transientBuffer->GetMappedData() + bufferOffset, m_transientBuffer.Get(), uint32_t(bufferOffset) };
+    }
+
     auto Context::CreateSetLayout(std::vector<SetLayoutBinding> bindings) -> SetLayoutHandle
     {
         std::sort(bindings.begin(), bindings.end(), [](const auto& a, const auto& b) { return a.binding < b.binding; });
@@ -258,14 +892,9 @@ void main()
             bindingFlags[i] = binding.bindingFlags;
         }
 
-        size_t hash = 0;
-        for(auto i = 0; i < bindings.size(); ++i)
-        {
-            HashCombine(hash, layoutBindings[i]);
-            HashCombine(hash, bindingFlags[i]);
-        }
-
-        // #TODO: Layout caching
+        std::lock_guard lock(m_setLayoutMutex);
+        if(const auto it = m_setLayoutCache.find(bindings); it != m_setLayoutCache.end())
+            return it->second;
 
         vk::DescriptorSetLayoutBindingFlagsCreateInfo bindingsFlagsInfo{};
         bindingsFlagsInfo.setBindingFlags(bindingFlags);
@@ -276,166 +905,56 @@ void main()
         layoutInfo.setPNext(&bindingsFlagsInfo);
         const auto layout = m_device.createDescriptorSetLayout(layoutInfo);
 
-        return IntrusivePtr(new SetLayout(this, layout, hash));
+        auto setLayout = IntrusivePtr(new SetLayout(this, layout, SetLayoutBindingsHash{}(bindings)));
+        m_setLayoutCache.emplace(std::move(bindings), setLayout);
+        return setLayout;
     }
 
-    auto Context::CreatePipelineLayout(const PipelineLayoutCreateInfo& info) -> PipelineLayoutHandle
-    {
-#if 0
-		size_t hash = 0;
-		HashCombine(hash, info.PushConstantRange);
+    auto Context::CreatePipelineLayout(const PipelineLayoutCreateInfo& info) -> PipelineLayoutHandle { return PipelineLayout::New(this, info); }
 
-		std::vector<vk::DescriptorSetLayout> setLayouts(info.SetLayouts.size());
-		for (auto i = 0u; i < info.SetLayouts.size(); ++i)
-		{
-			HashCombine(hash, i);
-			if (info.SetLayouts[i])
-			{
-				HashCombine(hash, info.SetLayouts[i]->GetHash());
-				setLayouts[i] = info.SetLayouts[i]->GetLayout();
-			}
-			else
-				HashCombine(hash, 0);
-		}
+    auto Context::CreateGraphicsPipeline(const GraphicsPipelineCreateInfo& info) -> PipelineHandle { return Pipeline::NewGraphics(this, info); }
 
-		// #TODO: Layout caching
+    auto Context::CreateComputePipeline(const ComputePipelineCreateInfo& info) -> PipelineHandle { return Pipeline::NewCompute(this, info); }
 
-		vk::PipelineLayoutCreateInfo layoutInfo{};
-		if (info.PushConstantRange.size > 0)
-			layoutInfo.setPushConstantRanges(info.PushConstantRange);
-		layoutInfo.setSetLayouts(setLayouts);
-		auto layout = m_device.createPipelineLayout(layoutInfo);
+    auto Context::CreateImage(ImageCreateInfo info, const ImageDataSource* pInitialData) -> ImageHandle
+    {
+        auto pImage = Image::New(this, info);
 
-		return IntrusivePtr(new PipelineLayout(this, layout, hash));
-#endif
+        const bool genMipMaps = (info.flags & (ImageCreateFlags_GenMipMaps | ImageCreateFlags_GenMipMapsCompute)) != 0;
+        if(pImage && pInitialData && !UploadImageData(pImage, *pInitialData, genMipMaps, true))
+            return nullptr;
 
-        return PipelineLayout::New(this, info);
+        return pImage;
     }
 
-    auto Context::CreateGraphicsPipeline(const GraphicsPipelineCreateInfo& info) -> PipelineHandle { return Pipeline::NewGraphics(this, info); }
+    auto Context::CreateImageAsync(ImageCreateInfo info, const ImageDataSource& initialData) -> AsyncResource<ImageHandle>
+    {
+        AsyncResource<ImageHandle> result{};
+        result.Handle = Image::New(this, info);
+        if(!result.Handle)
+            return result;
+
+        const bool genMipMaps = (info.flags & (ImageCreateFlags_GenMipMaps | ImageCreateFlags_GenMipMapsCompute)) != 0;
+        if(const auto ready = UploadImageData(result.Handle, initialData, genMipMaps, false))
+            result.Ready = *ready;
+        else
+            result.Handle = nullptr;
+        return result;
+    }
 
-    auto Context::CreateComputePipeline(const ComputePipelineCreateInfo& info) -> PipelineHandle { return Pipeline::NewCompute(this, info); }
+    auto Context::CreateAliasedImages(const std::vector<ImageCreateInfo>& infos) -> std::vector<ImageHandle> { return Image::NewAliased(this, infos); }
 
-    auto Context::CreateImage(ImageCreateInfo info, const ImageDataSource* pInitialData) -> ImageHandle
+    auto Context::CreateImageView(const Image* image, const ImageViewCreateInfo& info) -> ImageViewHandle
     {
-        auto pImage = Image::New(this, info);
-
-        if(pInitialData)
+        auto view = IntrusivePtr(new ImageView(this, image, CreateImageViewHandle(image, info), info));
+        if(image->m_allocation && image->GetMemoryCategory() == MemoryCategory::Texture)
         {
-            // Staging buffer.
-            BufferDataSource bufferSource{
-                .size = pInitialData->size,
-                .pData = pInitialData->data,
-            };
-            auto pStagingBuffer = CreateBuffer(BufferCreateInfo::Staging(pInitialData->size), &bufferSource);
-            assert(pStagingBuffer->IsHostAccessible());
-            SetName(*pStagingBuffer, "image_upload_staging_buffer");
-            auto cmd = RequestCmd();
-
-            // Transition all mip levels to TransferDst.
-            ImageTransitionInfo preTransitionInfo{
-                .pImage = pImage.Get(),
-                .oldLayout = vk::ImageLayout::eUndefined,
-                .newLayout = vk::ImageLayout::eTransferDstOptimal,
-                .mipLevelCount = pImage->GetMipLevels(),
-            };
-            cmd->TransitionImage(preTransitionInfo); // #TODO: Transition all mip levels to TransferDst
-
-            BufferToImageCopyInfo copyInfo{
-                .pSrcBuffer = pStagingBuffer.Get(),
-                .pDstImage = pImage.Get(),
-            };
-            cmd->CopyBufferToImage(copyInfo);
-
-            if(info.flags & ImageCreateFlags_GenMipMaps)
-            {
-                // Generate MipMaps.
-                auto mipWidth = int32_t(pImage->GetWidth());
-                auto mipHeight = int32_t(pImage->GetHeight());
-
-                for(auto i = 1u; i < pImage->GetMipLevels(); ++i)
-                {
-                    // Transition src mip to TransferSrc
-                    ImageTransitionInfo srcTransition{
-                        .pImage = pImage.Get(),
-                        .oldLayout = vk::ImageLayout::eTransferDstOptimal,
-                        .newLayout = vk::ImageLayout::eTransferSrcOptimal,
-                        .baseMipLevel = i - 1,
-                        .mipLevelCount = 1,
-                    };
-                    cmd->TransitionImage(srcTransition);
-
-                    // Blit src mip to dst mip
-
-                    ImageBlitInfo blitInfo{
-                        .pSrcImage = pImage.Get(),
-                        .srcRectEnd = {mipWidth, mipHeight, 1, },
-                        .srcMipLevel = i - 1,
-                        .pDstImage = pImage.Get(),
-                        .dstRectEnd = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1, },
-                        .dstMipLevel = i,
-                        .filter = vk::Filter::eLinear,
-                    };
-                    cmd->BlitImage(blitInfo);
-
-                    // Transition src mip to ShaderReadOnly
-                    ImageTransitionInfo shaderReadTransition{
-                        .pImage = pImage.Get(),
-                        .oldLayout = vk::ImageLayout::eTransferSrcOptimal,
-                        .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-                        .baseMipLevel = i - 1,
-                        .mipLevelCount = 1,
-                    };
-                    cmd->TransitionImage(shaderReadTransition);
-
-                    if(mipWidth > 1)
-                        mipWidth /= 2;
-                    if(mipHeight > 1)
-                        mipHeight /= 2;
-                }
-
-                // Transition last mip level to ShaderReadOnly
-                ImageTransitionInfo postTransitionInfo{
-                    .pImage = pImage.Get(),
-                    .oldLayout = vk::ImageLayout::eTransferDstOptimal,
-                    .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-                    .baseMipLevel = pImage->GetMipLevels() - 1,
-                    .mipLevelCount = 1,
-                };
-                cmd->TransitionImage(postTransitionInfo);
-            }
-            else
-            {
-                // Transition all mip levels to ShaderReadOnly
-                ImageTransitionInfo postTransitionInfo{
-                    .pImage = pImage.Get(),
-                    .oldLayout = vk::ImageLayout::eTransferDstOptimal,
-                    .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
-                    .mipLevelCount = pImage->GetMipLevels(),
-                };
-                cmd->TransitionImage(postTransitionInfo);
-            }
-
-            SubmitStaging(cmd);
+            // Recreated if defragmentation moves the image.
+            std::lock_guard lock(m_defragMutex);
+            view->m_tracked = true;
+            m_textureViews.emplace(image, view.Get());
         }
-
-        return pImage;
-    }
-
-    auto Context::CreateImageView(const Image* image, const ImageViewCreateInfo& info) -> ImageViewHandle
-    {
-        vk::ImageViewCreateInfo viewInfo{};
-        viewInfo.setImage(image->GetImage());
-        viewInfo.setFormat(image->GetFormat());
-        viewInfo.setViewType(vk::ImageViewType::e2D);
-        viewInfo.subresourceRange.setAspectMask(image->GetAspect());
-        viewInfo.subresourceRange.setBaseMipLevel(info.baseMipLevel);
-        viewInfo.subresourceRange.setLevelCount(info.mipLevelCount);
-        viewInfo.subresourceRange.setBaseArrayLayer(info.baseArrayLayer);
-        viewInfo.subresourceRange.setLayerCount(info.arrayLayerCount);
-        auto view = m_device.createImageView(viewInfo);
-
-        return IntrusivePtr(new ImageView(this, image, view, info));
+        return view;
     }
 
     auto Context::CreateSampler(const SamplerCreateInfo& info) -> SamplerHandle
@@ -458,54 +977,143 @@ void main()
     {
         auto pBuffer = Buffer::New(this, info);
 
-        if(pInitialData != nullptr)
+        if(pBuffer && pInitialData != nullptr && !UploadBufferData(pBuffer, *pInitialData, true))
+            return nullptr;
+
+        return pBuffer;
+    }
+
+    auto Context::CreateBufferAsync(const BufferCreateInfo& info, const BufferDataSource& initialData) -> AsyncResource<BufferHandle>
+    {
+        AsyncResource<BufferHandle> result{};
+        result.Handle = Buffer::New(this, info);
+        if(!result.Handle)
+            return result;
+
+        if(const auto ready = UploadBufferData(result.Handle, initialData, false))
+            result.Ready = *ready;
+        else
+            result.Handle = nullptr;
+        return result;
+    }
+
+    auto Context::CreateQueryPool(const QueryPoolCreateInfo& info) -> QueryPoolHandle { return QueryPool::New(this, info); }
+
+    auto Context::CreateUploadContext() -> UploadContextHandle { return IntrusivePtr(new UploadContext(this)); }
+
+    auto Context::CreateGeometryPool(const GeometryPoolCreateInfo& info) -> GeometryPoolHandle { return GeometryPool::New(this, info); }
+
+    void Context::BeginUploadBatch()
+    {
+        std::lock_guard lock(m_uploadBatchMutex);
+        if(m_uploadBatch.Active)
         {
-            if(pBuffer->IsHostAccessible())
-            {
-                auto* dataPtr = pBuffer->Map();
-                std::memcpy(dataPtr, pInitialData->pData, pInitialData->size);
-                pBuffer->Unmap();
-            }
-            else
+            VM_WARN("Upload batch has already begun");
+            return;
+        }
+        m_uploadBatch.Active = true;
+    }
+
+    auto Context::EndUploadBatch() -> SyncPoint
+    {
+        UploadBatch batch{};
+        {
+            std::lock_guard lock(m_uploadBatchMutex);
+            if(!m_uploadBatch.Active)
             {
-                // Staging buffer.
-                auto pStagingBuffer = CreateBuffer(BufferCreateInfo::Staging(info.size), pInitialData);
-                assert(pStagingBuffer->IsHostAccessible());
-                SetName(*pStagingBuffer, "buffer_upload_staging_buffer");
-                auto cmd = RequestCmd();
-
-                BufferCopyInfo copyInfo{
-                    .pSrcBuffer = pStagingBuffer.Get(),
-                    .pDstBuffer = pBuffer.Get(),
-                    .size = info.size,
-                };
-                cmd->CopyBuffer(copyInfo);
-                SubmitStaging(cmd);
+                VM_WARN("Upload batch has not begun");
+                return {};
             }
+            batch = std::move(m_uploadBatch);
+            m_uploadBatch = {};
         }
+        return SubmitUploadBatch(batch);
+    }
 
-        return pBuffer;
+    void Context::DestroySetLayout(vk::DescriptorSetLayout setLayout) { BinGarbage(setLayout); }
+
+    void Context::DestroyDescriptorSet(vk::DescriptorSet set)
+    {
+        {
+            std::lock_guard lock(m_descriptorPoolMutex);
+            std::erase_if(m_staticSets, [set](const auto* pSet) { return pSet->GetSet() == set; });
+        }
+        BinGarbage(set);
     }
 
-    auto Context::CreateQueryPool(const QueryPoolCreateInfo& info) -> QueryPoolHandle { return QueryPool::New(this, info); }
+    void Context::DestroyPipelineLayout(vk::PipelineLayout pipelineLayout) { BinGarbage(pipelineLayout); }
+
+    void Context::DestroyPipeline(vk::Pipeline pipeline) { BinGarbage(pipeline); }
+
+    void Context::DestroyImage(vk::Image image) { BinGarbage(image); }
 
-    void Context::DestroySetLayout(vk::DescriptorSetLayout setLayout) { GetFrame().Garbage->Bin(setLayout); }
+    void Context::DestroyImageView(vk::ImageView view) { BinGarbage(view); }
 
-    void Context::DestroyPipelineLayout(vk::PipelineLayout pipelineLayout) { GetFrame().Garbage->Bin(pipelineLayout); }
+    void Context::DestroySampler(vk::Sampler sampler) { BinGarbage(sampler); }
 
-    void Context::DestroyPipeline(vk::Pipeline pipeline) { GetFrame().Garbage->Bin(pipeline); }
+    void Context::DestroyBuffer(vk::Buffer buffer) { BinGarbage(buffer); }
 
-    void Context::DestroyImage(vk::Image image) { GetFrame().Garbage->Bin(image); }
+    void Context::DestroyAllocation(vma::Allocation alloc) { BinGarbage(alloc); }
 
-    void Context::DestroyImageView(vk::ImageView view) { GetFrame().Garbage->Bin(view); }
+    void Context::DestroyQueryPool(vk::QueryPool pool) { BinGarbage(pool); }
 
-    void Context::DestroySampler(vk::Sampler sampler) { GetFrame().Garbage->Bin(sampler); }
+    auto Context::GetMemoryBudget() const -> std::vector<MemoryHeapBudget>
+    {
+        const auto memProps = m_gpu.getMemoryProperties();
+        const auto budgets = m_allocator.getHeapBudgets();
 
-    void Context::DestroyBuffer(vk::Buffer buffer) { GetFrame().Garbage->Bin(buffer); }
+        std::vector<MemoryHeapBudget> heapBudgets(memProps.memoryHeapCount);
+        for(auto i = 0u; i < memProps.memoryHeapCount; ++i)
+        {
+            heapBudgets[i] = {
+                .Usage = budgets[i].usage,
+                .Budget = budgets[i].budget,
+                .BlockBytes = budgets[i].statistics.blockBytes,
+                .AllocationBytes = budgets[i].statistics.allocationBytes,
+                .DeviceLocal = bool(memProps.memoryHeaps[i].flags & vk::MemoryHeapFlagBits::eDeviceLocal),
+            };
+        }
+        return heapBudgets;
+    }
 
-    void Context::DestroyAllocation(vma::Allocation alloc) { GetFrame().Garbage->Bin(alloc); }
+    auto Context::GetMemoryStats(MemoryCategory category) const -> MemoryCategoryStats
+    {
+        return {
+            .Bytes = m_memoryBytes[uint8_t(category)].load(std::memory_order_relaxed),
+            .AllocationCount = m_memoryAllocationCounts[uint8_t(category)].load(std::memory_order_relaxed),
+        };
+    }
+
+    auto Context::BuildMemoryStatsString(bool detailed) const -> std::string
+    {
+        auto* pStats = m_allocator.buildStatsString(detailed);
+        std::string stats = pStats;
+        m_allocator.freeStatsString(pStats);
+        return stats;
+    }
+
+    bool Context::BeginDefragmentation(uint64_t maxBytesPerPass)
+    {
+        std::lock_guard lock(m_defragMutex);
+        if(m_defrag.Context != VK_NULL_HANDLE)
+            return true;
+
+        VmaDefragmentationInfo defragInfo{};
+        defragInfo.flags = VMA_DEFRAGMENTATION_FLAG_ALGORITHM_BALANCED_BIT;
+        defragInfo.maxBytesPerPass = maxBytesPerPass;
+        if(vmaBeginDefragmentation(static_cast<VmaAllocator>(m_allocator), &defragInfo, &m_defrag.Context) != VK_SUCCESS)
+        {
+            VM_ERR("Failed to begin defragmentation");
+            return false;
+        }
+        return true;
+    }
 
-    void Context::DestroyQueryPool(vk::QueryPool pool) { GetFrame().Garbage->Bin(pool); }
+    bool Context::IsDefragmenting()
+    {
+        std::lock_guard lock(m_defragMutex);
+        return m_defrag.Context != VK_NULL_HANDLE;
+    }
 
     void Context::SetName(const Buffer& buffer, const std::string& name)
     {
@@ -574,7 +1182,22 @@ void main()
         return false;
     }
 
-    bool Context::InitInstance(vk::Instance& outInstance)
+    bool Context::FindDedicatedQueueFamily(uint32_t& outFamilyIndex, vk::PhysicalDevice gpu, vk::QueueFlags flags, vk::QueueFlags excludedFlags)
+    {
+        auto families = gpu.getQueueFamilyProperties();
+        for(auto i = 0u; i < families.size(); ++i)
+        {
+            if((families[i].queueFlags & flags) && !(families[i].queueFlags & excludedFlags))
+            {
+                outFamilyIndex = i;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool Context::InitInstance(vk::Instance& outInstance, bool headless)
     {
         // PrintInstanceInfo();
 
@@ -589,13 +1212,16 @@ void main()
         };
         std::vector<const char*> enabledExtensions{
             VK_EXT_DEBUG_UTILS_EXTENSION_NAME,
-            VK_KHR_SURFACE_EXTENSION_NAME,
+        };
+        if(!headless)
+        {
+            enabledExtensions.push_back(VK_KHR_SURFACE_EXTENSION_NAME);
 #ifdef _WIN32
-            VK_KHR_WIN32_SURFACE_EXTENSION_NAME,
+            enabledExtensions.push_back(VK_KHR_WIN32_SURFACE_EXTENSION_NAME);
 #elif __linux__
-            VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME,
+            enabledExtensions.push_back(VK_KHR_WAYLAND_SURFACE_EXTENSION_NAME);
 #endif
-        };
+        }
 
         vk::InstanceCreateInfo instanceInfo{};
         instanceInfo.setPApplicationInfo(&appInfo);
@@ -616,54 +1242,192 @@ void main()
         return outInstance != VK_NULL_HANDLE;
     }
 
-    bool Context::SelectGPU(vk::PhysicalDevice& outGPU, vk::Instance instance)
+    auto Context::QueryGPUInfo(vk::PhysicalDevice gpu, uint32_t index, bool headless) -> GPUInfo
+    {
+        const auto props = gpu.getProperties();
+
+        GPUInfo info{};
+        info.Index = index;
+        info.Name = props.deviceName.data();
+        info.Type = props.deviceType;
+        info.VendorId = props.vendorID;
+        info.DeviceId = props.deviceID;
+        info.ApiVersion = props.apiVersion;
+        info.DriverVersion = props.driverVersion;
+
+        const auto memProps = gpu.getMemoryProperties();
+        for(auto i = 0u; i < memProps.memoryHeapCount; ++i)
+        {
+            const auto& heap = memProps.memoryHeaps[i];
+            if(heap.flags & vk::MemoryHeapFlagBits::eDeviceLocal)
+                info.DeviceLocalMemory = std::max(info.DeviceLocalMemory, uint64_t(heap.size));
+        }
+        for(auto i = 0u; i < memProps.memoryTypeCount; ++i)
+        {
+            if(memProps.memoryTypes[i].propertyFlags & vk::MemoryPropertyFlagBits::eLazilyAllocated)
+                info.SupportsLazilyAllocatedMemory = true;
+        }
+
+        uint32_t familyIndex = 0;
+        info.HasDedicatedTransferQueue
+            = FindDedicatedQueueFamily(familyIndex, gpu, vk::QueueFlagBits::eTransfer, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute);
+        info.HasDedicatedComputeQueue = FindDedicatedQueueFamily(familyIndex, gpu, vk::QueueFlagBits::eCompute, vk::QueueFlagBits::eGraphics);
+        const bool hasGraphicsQueue = FindQueueFamily(familyIndex, gpu, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eTransfer);
+
+        const auto exts = gpu.enumerateDeviceExtensionProperties();
+        info.SupportsSwapChain = std::any_of(exts.begin(), exts.end(), [](const auto& ext) {
+            return std::string_view(ext.extensionName.data()) == VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+        });
+        info.SupportsMemoryBudget = std::any_of(exts.begin(), exts.end(), [](const auto& ext) {
+            return std::string_view(ext.extensionName.data()) == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+        });
+
+        if(info.ApiVersion >= VK_API_VERSION_1_3)
+        {
+            const auto features = gpu.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan12Features, vk::PhysicalDeviceVulkan13Features>();
+            const auto& features12 = features.get<vk::PhysicalDeviceVulkan12Features>();
+            const auto& features13 = features.get<vk::PhysicalDeviceVulkan13Features>();
+            info.SupportsRequiredFeatures = features13.dynamicRendering && features13.synchronization2 && features12.timelineSemaphore
+                                         && features12.hostQueryReset && features12.runtimeDescriptorArray && features12.descriptorBindingPartiallyBound
+                                         && features12.shaderSampledImageArrayNonUniformIndexing && features12.descriptorBindingSampledImageUpdateAfterBind
+                                         && features12.descriptorBindingStorageBufferUpdateAfterBind
+                                         && features12.descriptorBindingUniformBufferUpdateAfterBind;
+        }
+
+        if(!hasGraphicsQueue || !info.SupportsRequiredFeatures || (!headless && !info.SupportsSwapChain))
+            return info;
+
+        // Device type dominates. Then prefer more device memory & queues that let work overlap.
+        switch(info.Type)
+        {
+        case vk::PhysicalDeviceType::eDiscreteGpu:
+            info.Score = 10000;
+            break;
+        case vk::PhysicalDeviceType::eIntegratedGpu:
+            info.Score = 5000;
+            break;
+        case vk::PhysicalDeviceType::eVirtualGpu:
+            info.Score = 2500;
+            break;
+        case vk::PhysicalDeviceType::eCpu:
+            info.Score = 1000;
+            break;
+        default:
+            info.Score = 0;
+            break;
+        }
+        info.Score += int64_t(info.DeviceLocalMemory / (64 * 1024 * 1024)); // +16 per GiB
+        info.Score += info.HasDedicatedTransferQueue ? 100 : 0;
+        info.Score += info.HasDedicatedComputeQueue ? 100 : 0;
+
+        return info;
+    }
+
+    bool Context::SelectGPU(vk::PhysicalDevice& outGPU, GPUInfo& outGPUInfo, vk::Instance instance, const ContextCreateInfo& info)
     {
         auto gpus = instance.enumeratePhysicalDevices();
         if(gpus.empty())
             return false;
 
-        // #TODO: Prefer dedicated gpu with most device memory.
-        outGPU = gpus[0];
+        std::vector<GPUInfo> gpuInfos(gpus.size());
+        for(auto i = 0u; i < gpus.size(); ++i)
+            gpuInfos[i] = QueryGPUInfo(gpus[i], i, info.headless);
+
+        // VKMANA_GPU (index or part of the device name) takes precedence over ContextCreateInfo::gpuIndex.
+        int32_t overrideIndex = info.gpuIndex;
+        if(const auto* pEnvGPU = std::getenv("VKMANA_GPU"); pEnvGPU != nullptr && *pEnvGPU != '\0')
+        {
+            const std::string_view envGPU(pEnvGPU);
+            if(std::all_of(envGPU.begin(), envGPU.end(), [](char c) { return std::isdigit(static_cast<unsigned char>(c)); }))
+            {
+                overrideIndex = std::atoi(pEnvGPU);
+            }
+            else
+            {
+                const auto it = std::find_if(gpuInfos.begin(), gpuInfos.end(), [&](const auto& gpuInfo) { return gpuInfo.Name.find(envGPU) != std::string::npos; });
+                if(it != gpuInfos.end())
+                    overrideIndex = int32_t(it->Index);
+                else
+                    VM_WARN("VKMANA_GPU={} does not match any GPU", envGPU);
+            }
+        }
+
+        const GPUInfo* pSelected = nullptr;
+        if(overrideIndex >= 0)
+        {
+            if(size_t(overrideIndex) < gpuInfos.size() && gpuInfos[overrideIndex].Score >= 0)
+                pSelected = &gpuInfos[overrideIndex];
+            else
+                VM_WARN("GPU override {} is not a usable GPU. Falling back to scored selection.", overrideIndex);
+        }
+        if(pSelected == nullptr)
+        {
+            const auto it = std::max_element(gpuInfos.begin(), gpuInfos.end(), [](const auto& a, const auto& b) { return a.Score < b.Score; });
+            if(it->Score < 0)
+            {
+                VM_ERR("No GPU supports the required features.");
+                return false;
+            }
+            pSelected = &*it;
+        }
+
+        outGPU = gpus[pSelected->Index];
+        outGPUInfo = *pSelected;
 
-        auto gpuProps = outGPU.getProperties();
-        VM_INFO("GPU - {}", gpuProps.deviceName.data());
-        VM_INFO(
-            "  API - {}.{}.{}",
-            VK_API_VERSION_MAJOR(gpuProps.apiVersion),
-            VK_API_VERSION_MINOR(gpuProps.apiVersion),
-            VK_API_VERSION_PATCH(gpuProps.apiVersion)
-        );
         VM_INFO(
-            "  Driver - {}.{}.{}",
-            VK_API_VERSION_MAJOR(gpuProps.driverVersion),
-            VK_API_VERSION_MINOR(gpuProps.driverVersion),
-            VK_API_VERSION_PATCH(gpuProps.driverVersion)
+            "GPU - {} ({}, {} MiB, API {}.{}.{}, score {})",
+            outGPUInfo.Name,
+            vk::to_string(outGPUInfo.Type),
+            outGPUInfo.DeviceLocalMemory / (1024 * 1024),
+            VK_API_VERSION_MAJOR(outGPUInfo.ApiVersion),
+            VK_API_VERSION_MINOR(outGPUInfo.ApiVersion),
+            VK_API_VERSION_PATCH(outGPUInfo.ApiVersion),
+            outGPUInfo.Score
         );
 
         return outGPU != VK_NULL_HANDLE;
     }
 
-    bool Context::InitDevice(vk::Device& outDevice, QueueInfo& outQueueInfo, vk::PhysicalDevice gpu)
+    bool Context::InitDevice(vk::Device& outDevice, QueueArray& outQueues, QueueMap& outQueueMap, vk::PhysicalDevice gpu, const GPUInfo& gpuInfo, bool headless)
     {
         // PrintDeviceInfo(gpu);
 
         /* Extensions */
 
-        std::vector<const char*> enabledExtensions{
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME,
-        };
+        std::vector<const char*> enabledExtensions{};
+        if(!headless)
+            enabledExtensions.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+        if(gpuInfo.SupportsMemoryBudget)
+            enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
 
         /* Queues */
 
-        if(!FindQueueFamily(outQueueInfo.GraphicsFamilyIndex, gpu, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eTransfer))
+        if(!FindQueueFamily(outQueues[uint8_t(QueueType::Graphics)].FamilyIndex, gpu, vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eTransfer))
             return false;
 
+        outQueueMap.fill(uint8_t(QueueType::Graphics));
+        if(FindDedicatedQueueFamily(
+               outQueues[uint8_t(QueueType::Transfer)].FamilyIndex,
+               gpu,
+               vk::QueueFlagBits::eTransfer,
+               vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute
+           ))
+            outQueueMap[uint8_t(QueueType::Transfer)] = uint8_t(QueueType::Transfer);
+        if(FindDedicatedQueueFamily(outQueues[uint8_t(QueueType::Compute)].FamilyIndex, gpu, vk::QueueFlagBits::eCompute, vk::QueueFlagBits::eGraphics))
+            outQueueMap[uint8_t(QueueType::Compute)] = uint8_t(QueueType::Compute);
+
         float queuePriority = 0.5f;
         std::vector<vk::DeviceQueueCreateInfo> queueInfos{};
-        auto& graphicsQueueInfo = queueInfos.emplace_back();
-        graphicsQueueInfo.setQueueFamilyIndex(outQueueInfo.GraphicsFamilyIndex);
-        graphicsQueueInfo.setQueuePriorities(queuePriority);
-        graphicsQueueInfo.setQueueCount(1);
+        for(auto i = 0u; i < outQueues.size(); ++i)
+        {
+            if(outQueueMap[i] != i)
+                continue;
+
+            auto& queueInfo = queueInfos.emplace_back();
+            queueInfo.setQueueFamilyIndex(outQueues[i].FamilyIndex);
+            queueInfo.setQueuePriorities(queuePriority);
+            queueInfo.setQueueCount(1);
+        }
 
         /* Features */
 
@@ -674,6 +1438,10 @@ void main()
         vk::PhysicalDeviceHostQueryResetFeatures hostQueryResetFeatures{};
         hostQueryResetFeatures.setHostQueryReset(VK_TRUE);
 
+        vk::PhysicalDeviceTimelineSemaphoreFeatures timelineSemaphoreFeatures{};
+        timelineSemaphoreFeatures.setTimelineSemaphore(VK_TRUE);
+        timelineSemaphoreFeatures.setPNext(&hostQueryResetFeatures);
+
         vk::PhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
         descriptorIndexingFeatures.setRuntimeDescriptorArray(VK_TRUE);          // Support SPIRV RuntimeDescriptorArray capability.
         descriptorIndexingFeatures.setDescriptorBindingPartiallyBound(VK_TRUE); // Descriptor sets do not need to have valid descriptors.
@@ -683,7 +1451,7 @@ void main()
         descriptorIndexingFeatures.setDescriptorBindingSampledImageUpdateAfterBind(VK_TRUE);
         descriptorIndexingFeatures.setDescriptorBindingStorageBufferUpdateAfterBind(VK_TRUE);
         descriptorIndexingFeatures.setDescriptorBindingUniformBufferUpdateAfterBind(VK_TRUE);
-        descriptorIndexingFeatures.setPNext(&hostQueryResetFeatures);
+        descriptorIndexingFeatures.setPNext(&timelineSemaphoreFeatures);
 
         vk::PhysicalDeviceSynchronization2Features sync2Features{};
         sync2Features.setSynchronization2(VK_TRUE);
@@ -704,23 +1472,709 @@ void main()
 
         VULKAN_HPP_DEFAULT_DISPATCHER.init(outDevice);
 
-        outQueueInfo.GraphicsQueue = outDevice.getQueue(outQueueInfo.GraphicsFamilyIndex, 0);
+        for(auto i = 0u; i < outQueues.size(); ++i)
+        {
+            if(outQueueMap[i] == i)
+                outQueues[i].Queue = outDevice.getQueue(outQueues[i].FamilyIndex, 0);
+        }
 
         VM_INFO("Enabled Device extensions:");
         for(const auto* ext : enabledExtensions)
             VM_INFO("  - {}", ext);
 
+        VM_INFO("Queue families:");
+        VM_INFO("  - Graphics: {}", outQueues[outQueueMap[uint8_t(QueueType::Graphics)]].FamilyIndex);
+        VM_INFO("  - Transfer: {}", outQueues[outQueueMap[uint8_t(QueueType::Transfer)]].FamilyIndex);
+        VM_INFO("  - Compute: {}", outQueues[outQueueMap[uint8_t(QueueType::Compute)]].FamilyIndex);
+
         return outDevice != VK_NULL_HANDLE;
     }
 
-    bool Context::SetupFrames()
+    auto Context::CreateTimelineSemaphore() const -> vk::Semaphore
+    {
+        vk::SemaphoreTypeCreateInfo typeInfo{};
+        typeInfo.setSemaphoreType(vk::SemaphoreType::eTimeline);
+        typeInfo.setInitialValue(0);
+
+        vk::SemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.setPNext(&typeInfo);
+        return m_device.createSemaphore(semaphoreInfo);
+    }
+
+    bool Context::IsTimelineValueReached(QueueType type, uint64_t value) const
+    {
+        return m_device.getSemaphoreCounterValue(GetTimelineSemaphore(type)) >= value;
+    }
+
+    void Context::WaitForTimelineValue(QueueType type, uint64_t value)
+    {
+        if(value == 0)
+            return;
+
+        // Waiting on a submission that has not reached the queue would never return.
+        Flush(type);
+
+        const auto semaphore = GetTimelineSemaphore(type);
+        vk::SemaphoreWaitInfo waitInfo{};
+        waitInfo.setSemaphores(semaphore);
+        waitInfo.setValues(value);
+        UNUSED(m_device.waitSemaphores(waitInfo, UINT64_MAX));
+    }
+
+    auto Context::AllocateStaging(const void* pData, uint64_t size) -> StagingAllocation
+    {
+        std::lock_guard lock(m_stagingMutex);
+        return GetFrame().Staging->Allocate(pData, size);
+    }
+
+    void Context::FlushTransientWrites()
+    {
+        if(m_transientBuffer->IsHostCoherent())
+            return;
+
+        std::lock_guard lock(m_transientMutex);
+        const auto& frame = GetFrame();
+        if(frame.TransientOffset != 0)
+            m_transientBuffer->Flush(m_transientFrameSize * m_frameIndex, frame.TransientOffset);
+    }
+
+    void Context::AddMemoryUsage(MemoryCategory category, uint64_t bytes)
+    {
+        m_memoryBytes[uint8_t(category)].fetch_add(bytes, std::memory_order_relaxed);
+        m_memoryAllocationCounts[uint8_t(category)].fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Context::RemoveMemoryUsage(MemoryCategory category, uint64_t bytes)
+    {
+        m_memoryBytes[uint8_t(category)].fetch_sub(bytes, std::memory_order_relaxed);
+        m_memoryAllocationCounts[uint8_t(category)].fetch_sub(1, std::memory_order_relaxed);
+    }
+
+    auto Context::FindCachedPipelineLayout(const PipelineLayoutKey& key) -> PipelineLayoutHandle
+    {
+        std::lock_guard lock(m_pipelineLayoutMutex);
+        const auto it = m_pipelineLayoutCache.find(key);
+        return it != m_pipelineLayoutCache.end() ? it->second : nullptr;
+    }
+
+    auto Context::CachePipelineLayout(PipelineLayoutKey key, const PipelineLayoutHandle& layout) -> PipelineLayoutHandle
+    {
+        std::lock_guard lock(m_pipelineLayoutMutex);
+        return m_pipelineLayoutCache.try_emplace(std::move(key), layout).first->second;
+    }
+
+    void Context::RegisterMovable(vma::Allocation allocation, Buffer* pBuffer, Image* pImage)
+    {
+        std::lock_guard lock(m_defragMutex);
+        m_movableResources[static_cast<VmaAllocation>(allocation)] = { pBuffer, pImage };
+    }
+
+    bool Context::ReleaseMovable(vma::Allocation allocation)
+    {
+        std::lock_guard lock(m_defragMutex);
+        const auto vmaAllocation = static_cast<VmaAllocation>(allocation);
+        if(m_movableResources.erase(vmaAllocation) == 0 || !m_defrag.PassActive)
+            return false;
+
+        for(auto i = 0u; i < m_defrag.Pass.moveCount; ++i)
+        {
+            auto& move = m_defrag.Pass.pMoves[i];
+            if(move.srcAllocation != vmaAllocation || move.operation != VMA_DEFRAGMENTATION_MOVE_OPERATION_COPY)
+                continue;
+
+            // VMA frees both places when the pass ends, so keep the pass open until this frame has completed.
+            move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_DESTROY;
+            m_defrag.PassFrame = m_frameNumber;
+            return true;
+        }
+        return false;
+    }
+
+    void Context::UntrackImageView(ImageView* pView)
+    {
+        std::lock_guard lock(m_defragMutex);
+        auto [begin, end] = m_textureViews.equal_range(pView->GetImage());
+        for(auto it = begin; it != end; ++it)
+        {
+            if(it->second == pView)
+            {
+                m_textureViews.erase(it);
+                break;
+            }
+        }
+    }
+
+    void Context::StepDefragmentation()
+    {
+        if(m_defrag.PassActive)
+        {
+            // Old handles may be used by frames in flight until the pass's last frame has completed.
+            if(m_frameNumber < m_defrag.PassFrame + m_frames.size())
+                return;
+            if(!EndDefragmentationPass())
+                return;
+        }
+        if(m_defrag.Context != VK_NULL_HANDLE)
+            BeginDefragmentationPass();
+    }
+
+    void Context::BeginDefragmentationPass()
+    {
+        {
+            // Uploads of resources in an open batch have not been recorded yet.
+            std::lock_guard batchLock(m_uploadBatchMutex);
+            if(m_uploadBatch.Active)
+                return;
+        }
+
+        const auto allocator = static_cast<VmaAllocator>(m_allocator);
+        if(vmaBeginDefragmentationPass(allocator, m_defrag.Context, &m_defrag.Pass) == VK_SUCCESS)
+        {
+            EndDefragmentation(); // Nothing left to move.
+            return;
+        }
+        m_defrag.PassActive = true;
+        m_defrag.PassFrame = m_frameNumber;
+
+        // Create & bind the new handles. Moves of unknown (e.g. mapped) allocations, and of resources whose last recorded
+        // barrier left them outside the graphics queue family or (textures) not entirely ShaderReadOnly, are ignored.
+        std::vector<std::tuple<Buffer*, vk::Buffer, VmaDefragmentationMove*>> buffers;
+        std::vector<std::tuple<Image*, vk::Image, VmaDefragmentationMove*>> images;
+        for(auto i = 0u; i < m_defrag.Pass.moveCount; ++i)
+        {
+            auto& move = m_defrag.Pass.pMoves[i];
+            const auto it = m_movableResources.find(move.srcAllocation);
+            if(it == m_movableResources.end() || (it->second.pBuffer && !it->second.pBuffer->m_ownedByGraphics)
+               || (it->second.pImage && !it->second.pImage->IsShaderReadOnly()))
+            {
+                move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                continue;
+            }
+
+            if(auto* pBuffer = it->second.pBuffer)
+            {
+                vk::BufferCreateInfo bufferInfo{};
+                bufferInfo.setSize(pBuffer->GetSize());
+                bufferInfo.setUsage(pBuffer->GetUsage());
+                auto buffer = m_device.createBuffer(bufferInfo);
+                if(vmaBindBufferMemory(allocator, move.dstTmpAllocation, buffer) != VK_SUCCESS)
+                {
+                    m_device.destroy(buffer);
+                    move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    continue;
+                }
+                buffers.emplace_back(pBuffer, buffer, &move);
+            }
+            else
+            {
+                // Recreated as created by Image::New. Copies below only cover single-sampled 2D images.
+                auto* pImage = it->second.pImage;
+                const auto& imageInfo = pImage->m_createInfo;
+                if(imageInfo.imageType != vk::ImageType::e2D || imageInfo.samples != vk::SampleCountFlagBits::e1)
+                {
+                    move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    continue;
+                }
+                auto image = m_device.createImage(imageInfo);
+                if(vmaBindImageMemory(allocator, move.dstTmpAllocation, image) != VK_SUCCESS)
+                {
+                    m_device.destroy(image);
+                    move.operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+                    continue;
+                }
+                images.emplace_back(pImage, image, &move);
+            }
+        }
+
+        // Static sets may still be read by frames in flight, so referencing sets switch to re-written copies.
+        // Resources referenced by a set without room for a copy stay where they are this pass.
+        std::unordered_set<const Buffer*> movedBuffers;
+        std::unordered_set<const Image*> movedImages;
+        for(const auto& [pBuffer, buffer, pMove] : buffers)
+            movedBuffers.insert(pBuffer);
+        for(const auto& [pImage, image, pMove] : images)
+            movedImages.insert(pImage);
+
+        std::unique_lock poolLock(m_descriptorPoolMutex);
+        std::vector<std::pair<DescriptorSet*, vk::DescriptorSet>> replacements;
+        for(auto* pSet : m_staticSets)
+        {
+            if(!pSet->References(movedBuffers, movedImages))
+                continue;
+
+            vk::DescriptorSetAllocateInfo allocInfo{};
+            allocInfo.setDescriptorPool(m_descriptorPool);
+            allocInfo.setSetLayouts(pSet->m_layout);
+            vk::DescriptorSet newSet;
+            if(m_device.allocateDescriptorSets(&allocInfo, &newSet) == vk::Result::eSuccess)
+            {
+                replacements.emplace_back(pSet, newSet);
+                continue;
+            }
+            VM_WARN("Defragmentation: Descriptor pool exhausted, resources of a static set are not moved this pass");
+            pSet->EraseReferenced(movedBuffers, movedImages);
+        }
+        // Earlier sets may no longer reference anything that moves.
+        std::erase_if(replacements, [&](const auto& replacement) {
+            if(replacement.first->References(movedBuffers, movedImages))
+                return false;
+            m_device.freeDescriptorSets(m_descriptorPool, replacement.second);
+            return true;
+        });
+
+        const auto excludeBuffer = [&](const auto& entry) {
+            const auto& [pBuffer, buffer, pMove] = entry;
+            if(movedBuffers.contains(pBuffer))
+                return false;
+            m_device.destroy(buffer);
+            pMove->operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            return true;
+        };
+        const auto excludeImage = [&](const auto& entry) {
+            const auto& [pImage, image, pMove] = entry;
+            if(movedImages.contains(pImage))
+                return false;
+            m_device.destroy(image);
+            pMove->operation = VMA_DEFRAGMENTATION_MOVE_OPERATION_IGNORE;
+            return true;
+        };
+        std::erase_if(buffers, excludeBuffer);
+        std::erase_if(images, excludeImage);
+        if(buffers.empty() && images.empty())
+            return;
+
+        auto cmd = RequestCmd();
+
+        // Wait for previous work on the old handles, then swap in the new ones. Textures were checked to be ShaderReadOnly above.
+        std::vector<ImageTransitionInfo> transitions;
+        std::vector<BufferBarrierInfo> bufferBarriers;
+        for(auto& [pBuffer, buffer, pMove] : buffers)
+        {
+            bufferBarriers.push_back({
+                .pBuffer = pBuffer,
+                .srcStage = vk::PipelineStageFlagBits2::eAllCommands,
+                .srcAccess = vk::AccessFlagBits2::eMemoryWrite,
+                .dstStage = vk::PipelineStageFlagBits2::eTransfer,
+                .dstAccess = vk::AccessFlagBits2::eTransferRead,
+            });
+        }
+        for(auto& [pImage, image, pMove] : images)
+        {
+            transitions.push_back({
+                .pImage = pImage,
+                .oldLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                .newLayout = vk::ImageLayout::eTransferSrcOptimal,
+                .mipLevelCount = pImage->GetMipLevels(),
+                .arrayLayerCount = pImage->GetDepthOrArrayLayers(),
+            });
+        }
+        cmd->PipelineBarrier(transitions, bufferBarriers);
+
+        for(auto& [pBuffer, buffer, pMove] : buffers)
+            std::swap(pBuffer->m_buffer, buffer);
+        for(auto& [pImage, image, pMove] : images)
+            std::swap(pImage->m_image, image);
+
+        for(auto& transition : transitions)
+        {
+            transition.oldLayout = vk::ImageLayout::eUndefined;
+            transition.newLayout = vk::ImageLayout::eTransferDstOptimal;
+        }
+        cmd->PipelineBarrier(transitions, {});
+
+        for(const auto& [pBuffer, oldBuffer, pMove] : buffers)
+        {
+            vk::BufferCopy region{ 0, 0, pBuffer->GetSize() };
+            cmd->GetCmd().copyBuffer(oldBuffer, pBuffer->GetBuffer(), region);
+        }
+        for(const auto& [pImage, oldImage, pMove] : images)
+        {
+            std::vector<vk::ImageCopy> regions(pImage->GetMipLevels());
+            for(auto mip = 0u; mip < pImage->GetMipLevels(); ++mip)
+            {
+                const vk::ImageSubresourceLayers subresource{ pImage->GetAspect(), mip, 0, pImage->GetDepthOrArrayLayers() };
+                regions[mip].setSrcSubresource(subresource);
+                regions[mip].setDstSubresource(subresource);
+                regions[mip].setExtent({ std::max(1u, pImage->GetWidth() >> mip), std::max(1u, pImage->GetHeight() >> mip), 1 });
+            }
+            cmd->GetCmd().copyImage(oldImage, vk::ImageLayout::eTransferSrcOptimal, pImage->GetImage(), vk::ImageLayout::eTransferDstOptimal, regions);
+        }
+
+        for(auto& barrier : bufferBarriers)
+        {
+            barrier.srcStage = vk::PipelineStageFlagBits2::eTransfer;
+            barrier.srcAccess = vk::AccessFlagBits2::eTransferWrite;
+            barrier.dstStage = vk::PipelineStageFlagBits2::eAllCommands;
+            barrier.dstAccess = vk::AccessFlagBits2::eMemoryRead | vk::AccessFlagBits2::eMemoryWrite;
+        }
+        for(auto& transition : transitions)
+        {
+            transition.oldLayout = vk::ImageLayout::eTransferDstOptimal;
+            transition.newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+        }
+        cmd->PipelineBarrier(transitions, bufferBarriers);
+
+        for(const auto& [pBuffer, oldBuffer, pMove] : buffers)
+            m_defrag.OldBuffers.push_back(oldBuffer);
+        for(const auto& [pImage, oldImage, pMove] : images)
+        {
+            m_defrag.OldImages.push_back(oldImage);
+
+            auto [begin, end] = m_textureViews.equal_range(pImage);
+            for(auto it = begin; it != end; ++it)
+            {
+                auto* pView = it->second;
+                m_defrag.OldViews.push_back(pView->m_view);
+                pView->m_view = CreateImageViewHandle(pImage, pView->m_info);
+            }
+        }
+
+        // The previous sets are binned with this frame & freed once it has retired, like the old handles at the end of the pass.
+        std::vector<vk::DescriptorSet> replacedSets;
+        for(auto& [pSet, newSet] : replacements)
+        {
+            replacedSets.push_back(pSet->GetSet());
+            pSet->RewriteMoved(newSet, movedBuffers, movedImages);
+        }
+        poolLock.unlock();
+        for(auto set : replacedSets)
+            BinGarbage(set);
+
+        Submit(cmd);
+    }
+
+    bool Context::EndDefragmentationPass()
+    {
+        const auto result = vmaEndDefragmentationPass(static_cast<VmaAllocator>(m_allocator), m_defrag.Context, &m_defrag.Pass);
+        m_defrag.PassActive = false;
+
+        for(auto buffer : m_defrag.OldBuffers)
+            m_device.destroy(buffer);
+        for(auto view : m_defrag.OldViews)
+            m_device.destroy(view);
+        for(auto image : m_defrag.OldImages)
+            m_device.destroy(image);
+        m_defrag.OldBuffers.clear();
+        m_defrag.OldViews.clear();
+        m_defrag.OldImages.clear();
+
+        if(result == VK_SUCCESS)
+        {
+            EndDefragmentation();
+            return false;
+        }
+        return true;
+    }
+
+    void Context::EndDefragmentation()
+    {
+        VmaDefragmentationStats stats{};
+        vmaEndDefragmentation(static_cast<VmaAllocator>(m_allocator), m_defrag.Context, &stats);
+        m_defrag.Context = VK_NULL_HANDLE;
+        VM_INFO("Defragmentation moved {} allocations ({} bytes), freed {} bytes", stats.allocationsMoved, stats.bytesMoved, stats.bytesFreed);
+    }
+
+    auto Context::CreateImageViewHandle(const Image* image, const ImageViewCreateInfo& info) -> vk::ImageView
+    {
+        vk::ImageViewCreateInfo viewInfo{};
+        viewInfo.setImage(image->GetImage());
+        viewInfo.setFormat(image->GetFormat());
+        viewInfo.setViewType(vk::ImageViewType::e2D);
+        viewInfo.subresourceRange.setAspectMask(image->GetAspect());
+        viewInfo.subresourceRange.setBaseMipLevel(info.baseMipLevel);
+        viewInfo.subresourceRange.setLevelCount(info.mipLevelCount);
+        viewInfo.subresourceRange.setBaseArrayLayer(info.baseArrayLayer);
+        viewInfo.subresourceRange.setLayerCount(info.arrayLayerCount);
+        return m_device.createImageView(viewInfo);
+    }
+
+    void Context::FreeDescriptorSets(const std::vector<vk::DescriptorSet>& sets)
+    {
+        std::lock_guard lock(m_descriptorPoolMutex);
+        m_device.freeDescriptorSets(m_descriptorPool, sets);
+    }
+
+    auto Context::AllocateReadback(uint64_t size) -> StagingAllocation
+    {
+        std::lock_guard lock(m_stagingMutex);
+        return GetFrame().Readback->Allocate(size);
+    }
+
+    void Context::ResolveReadbacks(PerFrame& frame)
+    {
+        // The frame's submissions have completed, so every readback is ready.
+        for(auto& readback : frame.Readbacks)
+        {
+            std::lock_guard lock(readback->m_mutex);
+            readback->Resolve();
+        }
+        frame.Readbacks.clear();
+    }
+
+    auto Context::SubmitUpload(CmdBuffer cmd, QueueOwnershipTransfer transfer) -> uint64_t
+    {
+        auto commandBuffer = cmd->GetCmd();
+        commandBuffer.end();
+
+        std::vector<vk::CommandBufferSubmitInfo> cmdInfos(1);
+        cmdInfos[0].setCommandBuffer(commandBuffer);
+
+        // Uploads are already batched by the UploadContext, so they go straight to the queue.
+        const auto transferValue = EnqueueSubmission(QueueType::Transfer, {}, std::move(cmdInfos));
+        Flush(QueueType::Transfer);
+
+        if(!transfer.Buffers.empty() || !transfer.Images.empty() || !transfer.MipMapImages.empty())
+        {
+            transfer.TransferValue = transferValue;
+
+            std::lock_guard ownershipLock(m_ownershipMutex);
+            m_pendingOwnershipTransfers.push_back(std::move(transfer));
+        }
+
+        return transferValue;
+    }
+
+    auto Context::UploadImageData(const ImageHandle& image, const ImageDataSource& data, bool genMipMaps, bool batchable) -> std::optional<SyncPoint>
+    {
+        const auto staging = AllocateStaging(data.data, data.size);
+        if(staging.pBuffer == nullptr)
+        {
+            VM_ERR("Failed to upload Image data (Staging allocation failed)");
+            return std::nullopt;
+        }
+
+        UploadBatch::ImageUpload upload{
+            .Image = image,
+            .Staging = staging,
+            .Subresources = data.subresources,
+            .GenMipMaps = genMipMaps && !data.HasMipChain(),
+        };
+        if(batchable)
+        {
+            std::lock_guard lock(m_uploadBatchMutex);
+            if(m_uploadBatch.Active)
+            {
+                m_uploadBatch.Images.push_back(std::move(upload));
+                return SyncPoint{}; // Completion is reported by EndUploadBatch.
+            }
+        }
+
+        UploadBatch batch{};
+        batch.Images.push_back(std::move(upload));
+        return SubmitUploadBatch(batch);
+    }
+
+    auto Context::UploadBufferData(const BufferHandle& buffer, const BufferDataSource& data, bool batchable) -> std::optional<SyncPoint>
+    {
+        if(buffer->IsHostAccessible())
+        {
+            auto* dataPtr = buffer->Map();
+            std::memcpy(dataPtr, data.pData, data.size);
+            buffer->Flush(0, data.size);
+            buffer->Unmap();
+            return SyncPoint{};
+        }
+
+        const auto staging = AllocateStaging(data.pData, data.size);
+        if(staging.pBuffer == nullptr)
+        {
+            VM_ERR("Failed to upload Buffer data (Staging allocation failed)");
+            return std::nullopt;
+        }
+
+        UploadBatch::BufferUpload upload{
+            .Buffer = buffer,
+            .Staging = staging,
+            .Size = data.size,
+        };
+        if(batchable)
+        {
+            std::lock_guard lock(m_uploadBatchMutex);
+            if(m_uploadBatch.Active)
+            {
+                m_uploadBatch.Buffers.push_back(std::move(upload));
+                return SyncPoint{}; // Completion is reported by EndUploadBatch.
+            }
+        }
+
+        UploadBatch batch{};
+        batch.Buffers.push_back(std::move(upload));
+        return SubmitUploadBatch(batch);
+    }
+
+    auto Context::SubmitUploadBatch(const UploadBatch& batch) -> SyncPoint
+    {
+        if(batch.Images.empty() && batch.Buffers.empty())
+            return {};
+
+        auto cmd = RequestCmd();
+
+        // Transition all mip levels of every image to TransferDst.
+        std::vector<ImageTransitionInfo> transitions;
+        for(const auto& upload : batch.Images)
+        {
+            transitions.push_back({
+                .pImage = upload.Image.Get(),
+                .oldLayout = vk::ImageLayout::eUndefined,
+                .newLayout = vk::ImageLayout::eTransferDstOptimal,
+                .mipLevelCount = upload.Image->GetMipLevels(),
+                .arrayLayerCount = upload.Image->GetDepthOrArrayLayers(),
+            });
+        }
+        cmd->PipelineBarrier(transitions, {});
+        transitions.clear();
+
+        for(const auto& upload : batch.Images)
+        {
+            BufferToImageCopyInfo copyInfo{
+                .pSrcBuffer = upload.Staging.pBuffer,
+                .pDstImage = upload.Image.Get(),
+                .srcOffset = upload.Staging.Offset,
+                .subresources = upload.Subresources,
+            };
+            cmd->CopyBufferToImage(copyInfo);
+        }
+        for(const auto& upload : batch.Buffers)
+        {
+            BufferCopyInfo copyInfo{
+                .pSrcBuffer = upload.Staging.pBuffer,
+                .pDstBuffer = upload.Buffer.Get(),
+                .size = upload.Size,
+                .srcOffset = upload.Staging.Offset,
+            };
+            cmd->CopyBuffer(copyInfo);
+        }
+
+        // Images without mips & buffers are made visible in one barrier. Mips are generated for all remaining images together.
+        std::vector<BufferBarrierInfo> bufferBarriers;
+        std::vector<const Image*> mipMapImages;
+        for(const auto& upload : batch.Images)
+        {
+            if(upload.GenMipMaps)
+            {
+                mipMapImages.push_back(upload.Image.Get());
+                continue;
+            }
+
+            transitions.push_back({
+                .pImage = upload.Image.Get(),
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                .mipLevelCount = upload.Image->GetMipLevels(),
+                .arrayLayerCount = upload.Image->GetDepthOrArrayLayers(),
+            });
+        }
+        for(const auto& upload : batch.Buffers)
+        {
+            bufferBarriers.push_back({
+                .pBuffer = upload.Buffer.Get(),
+                .srcStage = vk::PipelineStageFlagBits2::eTransfer,
+                .srcAccess = vk::AccessFlagBits2::eTransferWrite,
+                .dstStage = vk::PipelineStageFlagBits2::eAllCommands,
+                .dstAccess = vk::AccessFlagBits2::eMemoryRead,
+            });
+        }
+        cmd->PipelineBarrier(transitions, bufferBarriers);
+
+        if(!mipMapImages.empty())
+            GenerateMipMaps(cmd, mipMapImages);
+
+        return Submit(std::move(cmd));
+    }
+
+    auto Context::GetThreadCmdPool(QueueType queueType) -> CommandPool*
+    {
+        std::lock_guard lock(m_cmdPoolMutex);
+
+        auto& cmdPool = GetFrame().CmdPools[uint8_t(queueType)][std::this_thread::get_id()];
+        if(cmdPool == nullptr)
+            cmdPool = IntrusivePtr(new CommandPool(this, GetQueueFamily(queueType)));
+        return cmdPool.Get();
+    }
+
+    auto Context::EnqueueSubmission(QueueType queueType, std::vector<vk::SemaphoreSubmitInfo> waitInfos, std::vector<vk::CommandBufferSubmitInfo> cmdInfos)
+        -> uint64_t
+    {
+        auto& queue = GetQueueInfo(queueType);
+        auto lock = LockQueue(queueType);
+
+        // Without waits, command buffers can join the previous submission. It then signals the latest value,
+        // which also satisfies any wait on the values it replaced.
+        if(waitInfos.empty() && !queue.PendingSubmissions.empty())
+        {
+            auto& submission = queue.PendingSubmissions.back();
+            submission.CmdInfos.insert(submission.CmdInfos.end(), cmdInfos.begin(), cmdInfos.end());
+            submission.SignalValue = ++queue.TimelineValue;
+            return submission.SignalValue;
+        }
+
+        auto& submission = queue.PendingSubmissions.emplace_back();
+        submission.WaitInfos = std::move(waitInfos);
+        submission.CmdInfos = std::move(cmdInfos);
+        submission.SignalValue = ++queue.TimelineValue;
+        return submission.SignalValue;
+    }
+
+    void Context::RecordOwnershipAcquire(CmdBuffer& cmd, const QueueOwnershipTransfer& transfer)
+    {
+        const auto srcQueueFamily = GetQueueFamily(QueueType::Transfer);
+        const auto dstQueueFamily = GetQueueFamily(QueueType::Graphics);
+
+        for(const auto& buffer : transfer.Buffers)
+        {
+            BufferBarrierInfo acquireInfo{
+                .pBuffer = buffer.Get(),
+                .dstStage = vk::PipelineStageFlagBits2::eAllCommands,
+                .dstAccess = vk::AccessFlagBits2::eMemoryRead,
+                .srcQueueFamily = srcQueueFamily,
+                .dstQueueFamily = dstQueueFamily,
+            };
+            cmd->BufferBarrier(acquireInfo);
+        }
+
+        for(const auto& image : transfer.Images)
+        {
+            ImageTransitionInfo acquireInfo{
+                .pImage = image.Get(),
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                .mipLevelCount = image->GetMipLevels(),
+                .arrayLayerCount = image->GetDepthOrArrayLayers(),
+                .srcQueueFamily = srcQueueFamily,
+                .dstQueueFamily = dstQueueFamily,
+            };
+            cmd->TransitionImage(acquireInfo);
+        }
+
+        for(const auto& image : transfer.MipMapImages)
+        {
+            ImageTransitionInfo acquireInfo{
+                .pImage = image.Get(),
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eTransferDstOptimal,
+                .mipLevelCount = image->GetMipLevels(),
+                .arrayLayerCount = image->GetDepthOrArrayLayers(),
+                .srcQueueFamily = srcQueueFamily,
+                .dstQueueFamily = dstQueueFamily,
+            };
+            cmd->TransitionImage(acquireInfo);
+            GenerateMipMaps(cmd, image.Get());
+        }
+    }
+
+    bool Context::SetupFrames(uint32_t framesInFlight)
     {
-        m_frames.resize(2);
+        const auto frameCount = std::clamp(framesInFlight, MinFramesInFlight, MaxFramesInFlight);
+        if(frameCount != framesInFlight)
+            VM_WARN("Frames in flight ({}) clamped to {}", framesInFlight, frameCount);
+
+        m_frames.resize(frameCount);
         for(auto& frame : m_frames)
         {
-            frame.CmdPool = IntrusivePtr(new CommandPool(this, m_queueInfo.GraphicsFamilyIndex));
             frame.Garbage = IntrusivePtr(new GarbageBin(this));
             frame.DescriptorAllocator = IntrusivePtr(new DescriptorAllocator(this, 100));
+            frame.Staging = IntrusivePtr(new StagingRing(this));
+            frame.Readback = IntrusivePtr(new StagingRing(this, true));
         }
 
         m_frameIndex = 0;
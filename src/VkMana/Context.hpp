@@ -6,21 +6,94 @@
 #include "DescriptorAllocator.hpp"
 #include "Descriptors.hpp"
 #include "Garbage.hpp"
+#include "GeometryPool.hpp"
 #include "Image.hpp"
+#include "OffscreenTarget.hpp"
 #include "Pipeline.hpp"
 #include "QueryPool.hpp"
+#include "Readback.hpp"
+#include "StagingRing.hpp"
 #include "SwapChain.hpp"
+#include "UploadContext.hpp"
 #include "VulkanCommon.hpp"
 
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
 
 // #TODO: Present wait on last graphics semaphore (may want to submit 1 itself)
-// #TODO: Ability to create static descriptor sets (not reset every frame)
-// #TODO: Other queues (e.g. Transfer queue, compute queue) + Sync between them
-// #TODO: Upload context object (own command buffer + staging buffers) to be used in worker threads (1 per thread)
 
 namespace VkMana
 {
+    constexpr uint32_t MinFramesInFlight = 1;
+    constexpr uint32_t MaxFramesInFlight = 4;
+
+    struct ContextCreateInfo
+    {
+        uint32_t framesInFlight = 2; // Clamped to [MinFramesInFlight, MaxFramesInFlight].
+        bool headless = false;       // No surface/swapchain support. Render to an OffscreenTarget instead.
+        int32_t gpuIndex = -1;       // Physical device index to use instead of the highest scored. Overridden by the VKMANA_GPU env var (index or name).
+        uint64_t transientBufferSize = 4 * 1024 * 1024; // Per frame in flight. Capacity of Context::AllocateTransient.
+    };
+
+    struct TransientAllocation
+    {
+        uint8_t* pData = nullptr;
+        const Buffer* pBuffer = nullptr; // Always the Context's transient buffer.
+        uint32_t Offset = 0;             // Dynamic offset.
+    };
+
+    /**
+     * Capabilities of a physical device, as considered by GPU selection.
+     */
+    struct GPUInfo
+    {
+        uint32_t Index = 0; // Index in vkEnumeratePhysicalDevices.
+        std::string Name;
+        vk::PhysicalDeviceType Type = vk::PhysicalDeviceType::eOther;
+        uint32_t VendorId = 0;
+        uint32_t DeviceId = 0;
+        uint32_t ApiVersion = 0;
+        uint32_t DriverVersion = 0;
+        uint64_t DeviceLocalMemory = 0; // Size of the largest device-local heap.
+        bool HasDedicatedTransferQueue = false;
+        bool HasDedicatedComputeQueue = false;
+        bool SupportsSwapChain = false;
+        bool SupportsMemoryBudget = false;          // VK_EXT_memory_budget.
+        bool SupportsLazilyAllocatedMemory = false; // Memory for transient attachments that may never be backed (tile-based GPUs).
+        bool SupportsRequiredFeatures = false;      // Vulkan 1.3, dynamic rendering, sync2, timeline semaphores, descriptor indexing, host query reset.
+        int64_t Score = -1;                         // Negative if the device cannot be used.
+    };
+
+    struct MemoryHeapBudget
+    {
+        uint64_t Usage = 0;           // Bytes of the heap used by this process. Includes other APIs' usage with VK_EXT_memory_budget.
+        uint64_t Budget = 0;          // Bytes this process can use before allocations may fail or page. An estimate without VK_EXT_memory_budget.
+        uint64_t BlockBytes = 0;      // Allocated from the heap by VMA.
+        uint64_t AllocationBytes = 0; // Occupied by allocations within those blocks.
+        bool DeviceLocal = false;
+    };
+
+    struct MemoryCategoryStats
+    {
+        uint64_t Bytes = 0; // Allocation sizes of live resources in the category.
+        uint32_t AllocationCount = 0;
+    };
+
+    /**
+     * A resource whose initial data may still be uploading. Ready is the completion token.
+     */
+    template <typename T>
+    struct AsyncResource
+    {
+        T Handle;        // Null if creation or the upload failed.
+        SyncPoint Ready; // Already reached if there was nothing to upload.
+    };
+
     class Context : public IntrusivePtrEnabled<Context>
     {
     public:
@@ -29,7 +102,7 @@ namespace VkMana
         Context() = default;
         ~Context();
 
-        bool Init();
+        bool Init(const ContextCreateInfo& info = {});
 
         /* State */
 
@@ -38,34 +111,104 @@ namespace VkMana
 
         /* Commands & Submission (Per Frame) */
 
-        auto RequestCmd() -> CmdBuffer;
-
-        void Submit(CmdBuffer cmd);
+        /**
+         * Thread-safe. Each thread records from its own command pool, so command buffers can be recorded in parallel.
+         * Command buffers must be submitted from within the same frame (before the next BeginFrame).
+         */
+        auto RequestCmd(QueueType queueType = QueueType::Graphics) -> CmdBuffer;
+        /**
+         * Thread-safe. Records commands to run inside a render pass begun with secondary contents.
+         * Executed with CommandBuffer::ExecuteCommands. Viewport/Scissor & bindings are not inherited.
+         */
+        auto RequestSecondaryCmd(const RenderPassInfo& renderPass) -> CmdBuffer;
+
+        /**
+         * Submit to the queue the command buffer was requested for, after all wait points have been reached.
+         * Resources shared between queue families must be transferred with the queue family fields of barriers.
+         */
+        auto Submit(CmdBuffer cmd, const std::vector<SyncPoint>& waitPoints = {}, vk::PipelineStageFlags2 waitStages = vk::PipelineStageFlagBits2::eAllCommands)
+            -> SyncPoint;
+        /**
+         * Submit command buffers (e.g. recorded on different threads) in the order given.
+         * All must have been requested for the same queue.
+         */
+        auto Submit(
+            const std::vector<CmdBuffer>& cmds,
+            const std::vector<SyncPoint>& waitPoints = {},
+            vk::PipelineStageFlags2 waitStages = vk::PipelineStageFlagBits2::eAllCommands
+        ) -> SyncPoint;
         void SubmitStaging(CmdBuffer cmd);
 
+        /**
+         * Submissions are queued & sent to their queue in one batch at EndFrame.
+         * Flush earlier when other work (e.g. outside of this Context) depends on them.
+         * Host waits & cross-queue waits flush automatically.
+         */
+        void Flush(QueueType queueType);
+        void FlushQueues();
+
+        void TrimCommandPools(); // Each frame's pools are trimmed when next reset, e.g. after a spike in recording.
+        auto GetCommandPoolStats() -> CommandPoolStats; // Allocated across all frames. High-water mark of the busiest pool.
+
         /* Recording Utility */
 
         void DrawFullScreenQuad(CmdBuffer& cmd, ImageHandle& image);
+        void GenerateMipMaps(CmdBuffer& cmd, const Image* pImage); // Expects all mips in TransferDst. Leaves all mips in ShaderReadOnly.
+        /**
+         * Generates the same level of every image per barrier.
+         * Images created with ImageCreateFlags_GenMipMapsCompute are downsampled up to 4 levels per compute dispatch instead of blitted.
+         */
+        void GenerateMipMaps(CmdBuffer& cmd, const std::vector<const Image*>& images);
+        bool SupportsComputeMipMaps(vk::Format format) const; // Format can be a storage image in the mip map compute shader.
 
         /* Resources */
 
         auto CreateSurface(void* windowHandle) -> vk::SurfaceKHR;
 
         auto CreateSwapChain(vk::SurfaceKHR surface, uint32_t width, uint32_t height) -> SwapChainHandle;
+        auto CreateOffscreenTarget(uint32_t width, uint32_t height, vk::Format format = vk::Format::eR8G8B8A8Unorm) -> OffscreenTargetHandle;
 
-        auto RequestDescriptorSet(const SetLayout* layout) -> DescriptorSetHandle;
+        auto RequestDescriptorSet(const SetLayout* layout) -> DescriptorSetHandle; // Valid for the current frame.
+        auto CreateDescriptorSet(const SetLayout* layout) -> DescriptorSetHandle;  // Thread-safe. Not reset with the frame, freed once released.
 
-        auto CreateSetLayout(std::vector<SetLayoutBinding> bindings) -> SetLayoutHandle;
-        auto CreatePipelineLayout(const PipelineLayoutCreateInfo& info) -> PipelineLayoutHandle;
+        /**
+         * Thread-safe. Bump-allocates from the current frame's region of the transient buffer. Valid until the frame slot is reused.
+         * Write the transient buffer once to an eUniformBufferDynamic/eStorageBufferDynamic binding of a set from CreateDescriptorSet,
+         * then bind that set with Offset as its dynamic offset. Host writes are flushed when submissions are flushed to the queue.
+         */
+        auto AllocateTransient(uint64_t size, uint64_t alignment = 0) -> TransientAllocation; // 0 = Min uniform & storage buffer offset alignment.
+        auto GetTransientBuffer() const -> const Buffer* { return m_transientBuffer.Get(); }
+
+        auto CreateSetLayout(std::vector<SetLayoutBinding> bindings) -> SetLayoutHandle; // Thread-safe. Identical bindings share a cached layout.
+        auto CreatePipelineLayout(const PipelineLayoutCreateInfo& info) -> PipelineLayoutHandle; // Thread-safe. Identical layouts share a cached layout.
         auto CreateGraphicsPipeline(const GraphicsPipelineCreateInfo& info) -> PipelineHandle;
         auto CreateComputePipeline(const ComputePipelineCreateInfo& info) -> PipelineHandle;
         auto CreateImage(ImageCreateInfo info, const ImageDataSource* pInitialData = nullptr) -> ImageHandle;
+        auto CreateAliasedImages(const std::vector<ImageCreateInfo>& infos) -> std::vector<ImageHandle>; // See Image::NewAliased.
         auto CreateImageView(const Image* image, const ImageViewCreateInfo& info) -> ImageViewHandle;
         auto CreateSampler(const SamplerCreateInfo& info) -> SamplerHandle;
         auto CreateBuffer(const BufferCreateInfo& info, const BufferDataSource* pInitialData = nullptr) -> BufferHandle;
+        /**
+         * The upload is submitted on its own (never joins an upload batch), so its completion is known straight away.
+         * Poll or wait on Ready, or pass it as a wait point to Submit. Keep using fallback resources until it is reached.
+         * Submitted with the frame's other work at EndFrame, Flush to start it sooner.
+         */
+        auto CreateImageAsync(ImageCreateInfo info, const ImageDataSource& initialData) -> AsyncResource<ImageHandle>;
+        auto CreateBufferAsync(const BufferCreateInfo& info, const BufferDataSource& initialData) -> AsyncResource<BufferHandle>;
         auto CreateQueryPool(const QueryPoolCreateInfo& info) -> QueryPoolHandle;
+        auto CreateUploadContext() -> UploadContextHandle;
+        auto CreateGeometryPool(const GeometryPoolCreateInfo& info) -> GeometryPoolHandle;
+
+        /**
+         * Thread-safe. Initial data passed to CreateImage/CreateBuffer between Begin & End is recorded into one command buffer
+         * with merged barriers and sent as a single submission, instead of one submission per resource.
+         * Begin & End within the same frame. The resources must not be used by the GPU before the batch has been ended.
+         */
+        void BeginUploadBatch();
+        auto EndUploadBatch() -> SyncPoint; // Reached once every upload in the batch has completed.
 
         void DestroySetLayout(vk::DescriptorSetLayout setLayout);
+        void DestroyDescriptorSet(vk::DescriptorSet set); // Static sets only.
         void DestroyPipelineLayout(vk::PipelineLayout pipelineLayout);
         void DestroyPipeline(vk::Pipeline pipeline);
         void DestroyImage(vk::Image image);
@@ -75,6 +218,21 @@ namespace VkMana
         void DestroyAllocation(vma::Allocation alloc);
         void DestroyQueryPool(vk::QueryPool pool);
 
+        /* Memory */
+
+        auto GetMemoryBudget() const -> std::vector<MemoryHeapBudget>;              // Per memory heap. Refreshed every frame.
+        auto GetMemoryStats(MemoryCategory category) const -> MemoryCategoryStats; // Thread-safe. Tagged at Buffer::New/Image::New.
+        auto BuildMemoryStatsString(bool detailed = false) const -> std::string;    // JSON dump of the allocator's stats. Detailed lists every allocation.
+
+        /**
+         * Compacts device-local buffers & textures incrementally, one VMA defragmentation pass per BeginFrame.
+         * Moved resources keep their Buffer/Image objects, which are given new vk handles (& image views) at BeginFrame.
+         * Static descriptor sets (CreateDescriptorSet) are re-written, per-frame sets pick up the new handles when next written.
+         * Host-accessible buffers & render targets are never moved.
+         */
+        bool BeginDefragmentation(uint64_t maxBytesPerPass = 64 * 1024 * 1024);
+        bool IsDefragmenting();
+
         /* Debug */
 
         void SetName(const Buffer& buffer, const std::string& name);
@@ -90,67 +248,242 @@ namespace VkMana
         auto GetPhysicalDevice() const -> auto { return m_gpu; }
         auto GetDevice() const -> auto { return m_device; }
         auto GetAllocator() const -> auto { return m_allocator; }
+        auto GetGPUInfo() const -> const auto& { return m_gpuInfo; }
+        bool IsHeadless() const { return m_headless; }
+
+        auto GetGraphicsQueueFamily() const -> auto { return GetQueueFamily(QueueType::Graphics); }
+        auto GetGraphicsQueue() const -> auto { return GetQueue(QueueType::Graphics); }
 
-        auto GetGraphicsQueueFamily() const -> auto { return m_queueInfo.GraphicsFamilyIndex; }
-        auto GetGraphicsQueue() const -> auto { return m_queueInfo.GraphicsQueue; }
+        auto GetQueueFamily(QueueType type) const -> uint32_t { return GetQueueInfo(type).FamilyIndex; }
+        auto GetQueue(QueueType type) const -> vk::Queue { return GetQueueInfo(type).Queue; }
+        bool HasDedicatedQueue(QueueType type) const { return m_queueMap[uint8_t(type)] == uint8_t(type); }
+
+        auto GetTimelineSemaphore(QueueType type = QueueType::Graphics) const -> vk::Semaphore { return GetQueueInfo(type).TimelineSemaphore; }
+        auto GetTimelineValue(QueueType type = QueueType::Graphics) const -> uint64_t { return GetQueueInfo(type).TimelineValue; }
+        bool IsTimelineValueReached(QueueType type, uint64_t value) const;
+        void WaitForTimelineValue(QueueType type, uint64_t value);
+        bool IsReached(const SyncPoint& syncPoint) const { return IsTimelineValueReached(syncPoint.Queue, syncPoint.Value); }
+        void Wait(const SyncPoint& syncPoint) { WaitForTimelineValue(syncPoint.Queue, syncPoint.Value); }
 
         auto GetFrameBufferCount() const -> auto { return m_frames.size(); }
         auto GetFrameIndex() const -> auto { return m_frameIndex; }
+        auto GetFrameNumber() const -> auto { return m_frameNumber; } // Frames begun so far.
 
         auto GetNearestSampler() const -> auto { return m_nearestSampler.Get(); }
         auto GetLinearSampler() const -> auto { return m_linearSampler.Get(); }
 
     private:
+        friend class SwapChain;
+        friend class UploadContext;
+        friend class CommandBuffer;
+        friend class GarbageBin;
+        friend class Buffer;
+        friend class Image;
+        friend class ImageView;
+        friend class Sampler;
+        friend class PipelineLayout;
+
+        struct PendingSubmission
+        {
+            std::vector<vk::SemaphoreSubmitInfo> WaitInfos;
+            std::vector<vk::CommandBufferSubmitInfo> CmdInfos;
+            uint64_t SignalValue = 0;
+        };
         struct QueueInfo
         {
-            uint32_t GraphicsFamilyIndex = 0;
-            vk::Queue GraphicsQueue;
+            uint32_t FamilyIndex = 0;
+            vk::Queue Queue;
+            vk::Semaphore TimelineSemaphore; // Every submission signals the next value.
+            uint64_t TimelineValue = 0;      // Last value handed out to a submission. May not have been flushed yet.
+            std::vector<PendingSubmission> PendingSubmissions;
+            mutable std::mutex Mutex; // Queue submission must be externally synchronized.
         };
+        using QueueArray = std::array<QueueInfo, uint8_t(QueueType::Count)>;
+        using QueueMap = std::array<uint8_t, uint8_t(QueueType::Count)>;
 
         static void PrintInstanceInfo();
         static void PrintDeviceInfo(vk::PhysicalDevice gpu);
 
         static bool FindQueueFamily(uint32_t& outFamilyIndex, vk::PhysicalDevice gpu, vk::QueueFlags flags);
+        static bool FindDedicatedQueueFamily(uint32_t& outFamilyIndex, vk::PhysicalDevice gpu, vk::QueueFlags flags, vk::QueueFlags excludedFlags);
+
+        static bool InitInstance(vk::Instance& outInstance, bool headless);
+        static auto QueryGPUInfo(vk::PhysicalDevice gpu, uint32_t index, bool headless) -> GPUInfo;
+        static bool SelectGPU(vk::PhysicalDevice& outGPU, GPUInfo& outGPUInfo, vk::Instance instance, const ContextCreateInfo& info);
+        static bool InitDevice(
+            vk::Device& outDevice, QueueArray& outQueues, QueueMap& outQueueMap, vk::PhysicalDevice gpu, const GPUInfo& gpuInfo, bool headless
+        );
+
+        bool SetupFrames(uint32_t framesInFlight);
+
+        auto CreateTimelineSemaphore() const -> vk::Semaphore;
+
+        auto GetQueueInfo(QueueType type) -> QueueInfo& { return m_queues[m_queueMap[uint8_t(type)]]; }
+        auto GetQueueInfo(QueueType type) const -> const QueueInfo& { return m_queues[m_queueMap[uint8_t(type)]]; }
+        auto LockQueue(QueueType type) const -> std::unique_lock<std::mutex> { return std::unique_lock(GetQueueInfo(type).Mutex); }
+
+        auto GetThreadCmdPool(QueueType queueType) -> CommandPool*;
+        auto EnqueueSubmission(QueueType queueType, std::vector<vk::SemaphoreSubmitInfo> waitInfos, std::vector<vk::CommandBufferSubmitInfo> cmdInfos) -> uint64_t;
+        auto AllocateStaging(const void* pData, uint64_t size) -> StagingAllocation; // From the current frame's staging ring.
+        auto AllocateReadback(uint64_t size) -> StagingAllocation;                   // From the current frame's readback ring.
+        void FlushTransientWrites();
+        void AddMemoryUsage(MemoryCategory category, uint64_t bytes);
+        void RemoveMemoryUsage(MemoryCategory category, uint64_t bytes);
+
+        auto FindCachedPipelineLayout(const PipelineLayoutKey& key) -> PipelineLayoutHandle;
+        auto CachePipelineLayout(PipelineLayoutKey key, const PipelineLayoutHandle& layout) -> PipelineLayoutHandle; // Returns any already cached one.
 
-        static bool InitInstance(vk::Instance& outInstance);
-        static bool SelectGPU(vk::PhysicalDevice& outGPU, vk::Instance instance);
-        static bool InitDevice(vk::Device& outDevice, QueueInfo& outQueueInfo, vk::PhysicalDevice gpu);
+        void RegisterMovable(vma::Allocation allocation, Buffer* pBuffer, Image* pImage);
+        bool ReleaseMovable(vma::Allocation allocation); // True if the active defragmentation pass now frees the allocation.
+        void UntrackImageView(ImageView* pView);
 
-        bool SetupFrames();
+        // Drops static set write records of a resource being destroyed, so they are never dereferenced or matched by address again.
+        template <typename T>
+        void ForgetStaticDescriptors(const T* pResource)
+        {
+            std::lock_guard lock(m_descriptorPoolMutex);
+            for(auto* pSet : m_staticSets)
+                pSet->Forget(pResource);
+        }
+        void StepDefragmentation(); // Expects m_defragMutex to be held.
+        void BeginDefragmentationPass();
+        bool EndDefragmentationPass(); // False once there is nothing left to move.
+        void EndDefragmentation();
+        auto CreateImageViewHandle(const Image* image, const ImageViewCreateInfo& info) -> vk::ImageView;
+        void FreeDescriptorSets(const std::vector<vk::DescriptorSet>& sets); // Static sets, from m_descriptorPool.
+        auto SubmitUpload(CmdBuffer cmd, QueueOwnershipTransfer transfer) -> uint64_t;
+
+        struct UploadBatch
+        {
+            struct ImageUpload
+            {
+                ImageHandle Image;
+                StagingAllocation Staging;
+                std::vector<ImageSubresourceData> Subresources;
+                bool GenMipMaps = false;
+            };
+            struct BufferUpload
+            {
+                BufferHandle Buffer;
+                StagingAllocation Staging;
+                uint64_t Size = 0;
+            };
+
+            bool Active = false;
+            std::vector<ImageUpload> Images;
+            std::vector<BufferUpload> Buffers;
+        };
+        // Empty if the upload failed, so a failed upload is never mistaken for a completed one.
+        auto UploadImageData(const ImageHandle& image, const ImageDataSource& data, bool genMipMaps, bool batchable) -> std::optional<SyncPoint>;
+        auto UploadBufferData(const BufferHandle& buffer, const BufferDataSource& data, bool batchable) -> std::optional<SyncPoint>;
+        auto SubmitUploadBatch(const UploadBatch& batch) -> SyncPoint;
+
+        void GenerateMipMapsBlit(CmdBuffer& cmd, const std::vector<const Image*>& images);
+        void GenerateMipMapsCompute(CmdBuffer& cmd, const std::vector<const Image*>& images);
+        auto GetMipMapBlitFilter(vk::Format format) const -> vk::Filter;
+        auto GetMipMapPipeline(vk::Format format) -> Pipeline*;
+        void RecordOwnershipAcquire(CmdBuffer& cmd, const QueueOwnershipTransfer& transfer);
+
+        template <typename T>
+        void BinGarbage(T handle)
+        {
+            std::lock_guard lock(m_garbageMutex);
+            GetFrame().Garbage->Bin(handle);
+        }
 
         struct PerFrame
         {
-            std::vector<vk::Fence> FrameFences; // Waited on at start of frame & submitted at end of frame.
-            IntrusivePtr<CommandPool> CmdPool;
+            std::array<uint64_t, uint8_t(QueueType::Count)> TimelineValues{}; // Waited on at start of frame. Last value each queue signalled this frame.
+            std::array<std::unordered_map<std::thread::id, IntrusivePtr<CommandPool>>, uint8_t(QueueType::Count)> CmdPools; // Created lazily per recording thread.
+            bool TrimCmdPools = false;
 
             DescriptorAllocatorHandle DescriptorAllocator;
+            StagingRingHandle Staging; // Upload space for work submitted this frame.
+            StagingRingHandle Readback;
+            std::vector<ReadbackHandle> Readbacks; // Submitted this frame. Resolved before Readback is reset.
+            uint64_t TransientOffset = 0; // Into the frame's region of the transient buffer.
 
             IntrusivePtr<GarbageBin> Garbage;
         };
         std::vector<PerFrame> m_frames;
-        uint32_t m_frameIndex;
+        uint32_t m_frameIndex; // Written with m_garbageMutex & m_transientMutex held, so either guards reads.
+        uint64_t m_frameNumber = 0;
 
         auto GetFrame() -> auto& { return m_frames[m_frameIndex]; }
         auto GetFrame() const -> const auto& { return m_frames[m_frameIndex]; }
 
+        void ResolveReadbacks(PerFrame& frame); // Expects m_stagingMutex to be held & the frame's submissions to have completed.
+
     private:
         vk::Instance m_instance;
         vk::PhysicalDevice m_gpu;
+        GPUInfo m_gpuInfo;
         vk::Device m_device;
         vma::Allocator m_allocator;
-        vk::DescriptorPool m_descriptorPool;
+        vk::DescriptorPool m_descriptorPool; // Static descriptor sets.
+        bool m_headless = false;
 
         SamplerHandle m_nearestSampler;
         SamplerHandle m_linearSampler;
 
-        QueueInfo m_queueInfo{};
+        QueueArray m_queues{};
+        QueueMap m_queueMap{}; // Queue types without a dedicated family alias the graphics queue.
+
+        std::mutex m_garbageMutex; // Resources may be released from worker threads.
+        std::mutex m_cmdPoolMutex;
+        std::mutex m_descriptorAllocatorMutex;
+        std::mutex m_descriptorPoolMutex;
+        std::mutex m_stagingMutex;
 
-        std::vector<vk::Semaphore> m_submitWaitSemaphores;
-        std::vector<vk::PipelineStageFlags> m_submitWaitStageMasks;
-        std::vector<vk::Semaphore> m_presentWaitSemaphores;
+        std::array<std::atomic_uint64_t, uint8_t(MemoryCategory::Count)> m_memoryBytes{};
+        std::array<std::atomic_uint32_t, uint8_t(MemoryCategory::Count)> m_memoryAllocationCounts{};
+
+        struct MovableResource
+        {
+            Buffer* pBuffer = nullptr;
+            Image* pImage = nullptr;
+        };
+        struct DefragmentationState
+        {
+            VmaDefragmentationContext Context = VK_NULL_HANDLE;
+            VmaDefragmentationPassMoveInfo Pass{};
+            bool PassActive = false;
+            uint64_t PassFrame = 0; // Last frame the pass's old handles may have been used in.
+            std::vector<vk::Buffer> OldBuffers;
+            std::vector<vk::Image> OldImages;
+            std::vector<vk::ImageView> OldViews;
+        };
+        std::mutex m_defragMutex;
+        DefragmentationState m_defrag;
+        std::unordered_map<VmaAllocation, MovableResource> m_movableResources;
+        std::unordered_multimap<const Image*, ImageView*> m_textureViews;
+        std::vector<DescriptorSet*> m_staticSets; // Guarded by m_descriptorPoolMutex.
+
+        std::mutex m_transientMutex;
+        BufferHandle m_transientBuffer; // One region per frame in flight, so one descriptor covers every frame.
+        uint64_t m_transientFrameSize = 0;
+        uint64_t m_transientAlignment = 0;
+
+        std::mutex m_uploadBatchMutex;
+        UploadBatch m_uploadBatch;
+
+        std::mutex m_ownershipMutex;
+        std::vector<QueueOwnershipTransfer> m_pendingOwnershipTransfers; // Acquired by the next graphics submission.
+
+        std::mutex m_setLayoutMutex;
+        // Keyed by the sorted bindings, so equal hashes of different bindings never share a layout. Kept for the lifetime of the context.
+        std::unordered_map<std::vector<SetLayoutBinding>, SetLayoutHandle, SetLayoutBindingsHash> m_setLayoutCache;
+        std::mutex m_pipelineLayoutMutex;
+        // Never evicted, layouts live until the context is destroyed. Layouts are small & an application only creates a handful of distinct ones.
+        std::unordered_map<PipelineLayoutKey, PipelineLayoutHandle, PipelineLayoutKeyHash> m_pipelineLayoutCache;
 
         SetLayoutHandle m_singleImageSetLayout;
         PipelineHandle m_fullscreenQuadPipeline;
+
+        SetLayoutHandle m_mipMapSetLayout;
+        PipelineLayoutHandle m_mipMapPipelineLayout;
+        std::mutex m_mipMapPipelineMutex;
+        std::unordered_map<vk::Format, PipelineHandle> m_mipMapPipelines;
     };
     using ContextHandle = IntrusivePtr<Context>;
 
@@ -18,37 +18,26 @@ namespace VkMana
     {
         auto* pool = TryGetValidPool(setLayout);
         if(!pool)
-        {
-            uint32_t maxSets = 20;
-
-            // Create new pool
-            std::vector<vk::DescriptorPoolSize> poolSizes{};
-            for(auto& [type, multiplier] : m_poolSizeMultipliers)
-                poolSizes.emplace_back(type, uint32_t(multiplier * maxSets));
-
-            vk::DescriptorPoolCreateInfo poolInfo{};
-            poolInfo.setMaxSets(maxSets);
-            poolInfo.setPoolSizes(poolSizes);
-            poolInfo.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind);
-
-            auto& newPool = m_pools.emplace_back();
-            newPool.Layout = setLayout;
-            newPool.DescriptorPool = m_ctx->GetDevice().createDescriptorPool(poolInfo);
-            newPool.MaxSets = maxSets;
-
-            /*std::vector setLayouts(maxSets, newPool.Layout);
-            vk::DescriptorSetAllocateInfo setAllocInfo{};
-            setAllocInfo.setDescriptorPool(newPool.DescriptorPool);
-            setAllocInfo.setSetLayouts(setLayouts);
-            newPool.PreAllocatedSets = m_ctx->GetDevice().allocateDescriptorSets(setAllocInfo);*/
-
-            pool = &newPool;
-        }
+            pool = CreatePool(setLayout);
 
         vk::DescriptorSetAllocateInfo allocInfo{};
         allocInfo.setDescriptorPool(pool->DescriptorPool);
         allocInfo.setSetLayouts(setLayout);
-        auto set = m_ctx->GetDevice().allocateDescriptorSets(allocInfo)[0];
+        vk::DescriptorSet set;
+        auto result = m_ctx->GetDevice().allocateDescriptorSets(&allocInfo, &set);
+        if(result == vk::Result::eErrorOutOfPoolMemory || result == vk::Result::eErrorFragmentedPool)
+        {
+            // Pool sizes are estimates, so a layout with many descriptors can run out before MaxSets.
+            pool->Exhausted = true;
+            pool = CreatePool(setLayout);
+            allocInfo.setDescriptorPool(pool->DescriptorPool);
+            result = m_ctx->GetDevice().allocateDescriptorSets(&allocInfo, &set);
+        }
+        if(result != vk::Result::eSuccess)
+        {
+            VM_ERR("Failed to allocate Descriptor Set");
+            return nullptr;
+        }
         return set;
     }
 
@@ -58,6 +47,7 @@ namespace VkMana
         {
             // pool.PreAllocatedSets.clear();
             m_ctx->GetDevice().resetDescriptorPool(pool.DescriptorPool);
+            pool.Exhausted = false;
             // pool.SetIndex = 0;
 
             /*std::vector setLayouts(pool.MaxSets, pool.Layout);
@@ -90,7 +80,7 @@ namespace VkMana
     {
         for(auto& pool : m_pools)
         {
-            if(pool.Layout != setLayout)
+            if(pool.Layout != setLayout || pool.Exhausted)
                 continue;
 
             // if (pool.SetIndex >= pool.MaxSets)
@@ -101,4 +91,31 @@ namespace VkMana
         return nullptr;
     }
 
+    auto DescriptorAllocator::CreatePool(vk::DescriptorSetLayout setLayout) -> Pool*
+    {
+        uint32_t maxSets = 20;
+
+        std::vector<vk::DescriptorPoolSize> poolSizes{};
+        for(auto& [type, multiplier] : m_poolSizeMultipliers)
+            poolSizes.emplace_back(type, uint32_t(multiplier * maxSets));
+
+        vk::DescriptorPoolCreateInfo poolInfo{};
+        poolInfo.setMaxSets(maxSets);
+        poolInfo.setPoolSizes(poolSizes);
+        poolInfo.setFlags(vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind);
+
+        auto& newPool = m_pools.emplace_back();
+        newPool.Layout = setLayout;
+        newPool.DescriptorPool = m_ctx->GetDevice().createDescriptorPool(poolInfo);
+        newPool.MaxSets = maxSets;
+
+        /*std::vector setLayouts(maxSets, newPool.Layout);
+        vk::DescriptorSetAllocateInfo setAllocInfo{};
+        setAllocInfo.setDescriptorPool(newPool.DescriptorPool);
+        setAllocInfo.setSetLayouts(setLayouts);
+        newPool.PreAllocatedSets = m_ctx->GetDevice().allocateDescriptorSets(setAllocInfo);*/
+
+        return &newPool;
+    }
+
 } // namespace VkMana
\ No newline at end of file
@@ -27,10 +27,12 @@ namespace VkMana
             vk::DescriptorSetLayout Layout;
             vk::DescriptorPool DescriptorPool;
             uint32_t MaxSets;
+            bool Exhausted = false; // Out of sets or descriptors until the next reset, later allocations go to a new pool.
             // std::vector<vk::DescriptorSet> PreAllocatedSets; // #TODO: Consider pre-allocating maxSets each frame. Better performance?
             // uint32_t SetIndex = 0;
         };
         auto TryGetValidPool(vk::DescriptorSetLayout setLayout) -> Pool*;
+        auto CreatePool(vk::DescriptorSetLayout setLayout) -> Pool*;
 
     private:
         Context* m_ctx;
@@ -2,6 +2,8 @@
 
 #include "Context.hpp"
 
+#include <algorithm>
+
 namespace VkMana
 {
     SetLayout::~SetLayout()
@@ -10,6 +12,20 @@ namespace VkMana
             m_ctx->DestroySetLayout(m_layout);
     }
 
+    auto SetLayoutBindingsHash::operator()(const std::vector<SetLayoutBinding>& bindings) const -> size_t
+    {
+        size_t hash = 0;
+        for(const auto& binding : bindings)
+        {
+            HashCombine(hash, binding.binding);
+            HashCombine(hash, binding.type);
+            HashCombine(hash, binding.count);
+            HashCombine(hash, binding.stageFlags);
+            HashCombine(hash, binding.bindingFlags);
+        }
+        return hash;
+    }
+
     SetLayout::SetLayout(Context* context, vk::DescriptorSetLayout layout, size_t hash)
         : m_ctx(context)
         , m_layout(layout)
@@ -17,6 +33,12 @@ namespace VkMana
     {
     }
 
+    DescriptorSet::~DescriptorSet()
+    {
+        if(m_set && m_isStatic)
+            m_ctx->DestroyDescriptorSet(m_set);
+    }
+
     void DescriptorSet::Write(const ImageView* pImage, const Sampler* pSampler, uint32_t binding)
     {
         vk::DescriptorImageInfo imageInfo{};
@@ -31,6 +53,14 @@ namespace VkMana
         write.setDescriptorCount(1);
         write.setImageInfo(imageInfo);
         m_ctx->GetDevice().updateDescriptorSets(write, {});
+
+        Record({
+            .Binding = binding,
+            .Type = vk::DescriptorType::eCombinedImageSampler,
+            .pView = pImage,
+            .pSampler = pSampler,
+            .Layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+        });
     }
 
     void DescriptorSet::Write(uint32_t binding, const Buffer* pBuffer, uint64_t offset, uint64_t range, vk::DescriptorType descriptorType)
@@ -47,6 +77,14 @@ namespace VkMana
         write.setDescriptorCount(1);
         write.setBufferInfo(bufferInfo);
         m_ctx->GetDevice().updateDescriptorSets(write, {});
+
+        Record({
+            .Binding = binding,
+            .Type = descriptorType,
+            .pBuffer = pBuffer,
+            .Offset = offset,
+            .Range = range,
+        });
     }
 
     void DescriptorSet::WriteArray(uint32_t binding, uint32_t arrayOffset, const std::vector<const ImageView*>& images, const Sampler* sampler)
@@ -73,12 +111,152 @@ namespace VkMana
         }
 
         m_ctx->GetDevice().updateDescriptorSets(writes, {});
+
+        for(auto i = 0u; i < images.size(); ++i)
+        {
+            Record({
+                .Binding = binding,
+                .ArrayElement = arrayOffset + i,
+                .Type = vk::DescriptorType::eCombinedImageSampler,
+                .pView = images[i],
+                .pSampler = sampler,
+                .Layout = vk::ImageLayout::eShaderReadOnlyOptimal,
+            });
+        }
     }
 
-    DescriptorSet::DescriptorSet(Context* context, vk::DescriptorSet set)
+    void DescriptorSet::WriteStorageArray(uint32_t binding, uint32_t arrayOffset, const std::vector<const ImageView*>& images)
+    {
+        std::vector<vk::DescriptorImageInfo> imageInfos(images.size());
+        for(auto i = 0u; i < images.size(); ++i)
+        {
+            imageInfos[i].setImageView(images[i]->GetView());
+            imageInfos[i].setImageLayout(vk::ImageLayout::eGeneral);
+        }
+
+        vk::WriteDescriptorSet write{};
+        write.setDescriptorType(vk::DescriptorType::eStorageImage);
+        write.setDstSet(m_set);
+        write.setDstBinding(binding);
+        write.setDstArrayElement(arrayOffset);
+        write.setImageInfo(imageInfos);
+        m_ctx->GetDevice().updateDescriptorSets(write, {});
+
+        for(auto i = 0u; i < images.size(); ++i)
+        {
+            Record({
+                .Binding = binding,
+                .ArrayElement = arrayOffset + i,
+                .Type = vk::DescriptorType::eStorageImage,
+                .pView = images[i],
+                .Layout = vk::ImageLayout::eGeneral,
+            });
+        }
+    }
+
+    DescriptorSet::DescriptorSet(Context* context, vk::DescriptorSet set, bool isStatic, vk::DescriptorSetLayout layout)
         : m_ctx(context)
         , m_set(set)
+        , m_isStatic(isStatic)
+        , m_layout(layout)
     {
     }
 
+    void DescriptorSet::Record(const WriteRecord& record)
+    {
+        // Per-frame sets are re-written every frame anyway.
+        if(!m_isStatic)
+            return;
+
+        auto it = std::find_if(m_writes.begin(), m_writes.end(), [&](const auto& write) {
+            return write.Binding == record.Binding && write.ArrayElement == record.ArrayElement;
+        });
+        if(it != m_writes.end())
+            *it = record;
+        else
+            m_writes.push_back(record);
+    }
+
+    void DescriptorSet::Forget(const Buffer* pBuffer)
+    {
+        std::erase_if(m_writes, [&](const auto& write) { return write.pBuffer == pBuffer; });
+    }
+
+    void DescriptorSet::Forget(const Image* pImage)
+    {
+        std::erase_if(m_writes, [&](const auto& write) { return write.pView != nullptr && write.pView->GetImage() == pImage; });
+    }
+
+    void DescriptorSet::Forget(const ImageView* pView)
+    {
+        std::erase_if(m_writes, [&](const auto& write) { return write.pView == pView; });
+    }
+
+    void DescriptorSet::Forget(const Sampler* pSampler)
+    {
+        std::erase_if(m_writes, [&](const auto& write) { return write.pSampler == pSampler; });
+    }
+
+    bool DescriptorSet::References(const std::unordered_set<const Buffer*>& buffers, const std::unordered_set<const Image*>& images) const
+    {
+        return std::any_of(m_writes.begin(), m_writes.end(), [&](const auto& write) {
+            return (write.pBuffer != nullptr && buffers.contains(write.pBuffer)) || (write.pView != nullptr && images.contains(write.pView->GetImage()));
+        });
+    }
+
+    void DescriptorSet::EraseReferenced(std::unordered_set<const Buffer*>& buffers, std::unordered_set<const Image*>& images) const
+    {
+        for(const auto& write : m_writes)
+        {
+            if(write.pBuffer != nullptr)
+                buffers.erase(write.pBuffer);
+            if(write.pView != nullptr)
+                images.erase(write.pView->GetImage());
+        }
+    }
+
+    void DescriptorSet::RewriteMoved(vk::DescriptorSet newSet, const std::unordered_set<const Buffer*>& buffers, const std::unordered_set<const Image*>& images)
+    {
+        std::vector<vk::DescriptorBufferInfo> bufferInfos;
+        std::vector<vk::DescriptorImageInfo> imageInfos;
+        std::vector<const WriteRecord*> records;
+        std::vector<vk::CopyDescriptorSet> copies;
+        for(const auto& record : m_writes)
+        {
+            if(record.pBuffer != nullptr && buffers.contains(record.pBuffer))
+                bufferInfos.emplace_back(record.pBuffer->GetBuffer(), record.Offset, record.Range);
+            else if(record.pView != nullptr && images.contains(record.pView->GetImage()))
+                imageInfos.emplace_back(record.pSampler ? record.pSampler->GetSampler() : vk::Sampler(), record.pView->GetView(), record.Layout);
+            else
+            {
+                // Unchanged descriptors are copied. Those of destroyed resources have no record & are left unwritten.
+                if(newSet != m_set)
+                    copies.emplace_back(m_set, record.Binding, record.ArrayElement, newSet, record.Binding, record.ArrayElement, 1);
+                continue;
+            }
+            records.push_back(&record);
+        }
+
+        // Infos are stored up front, so the pointers taken below stay valid.
+        std::vector<vk::WriteDescriptorSet> writes;
+        auto bufferIndex = 0u;
+        auto imageIndex = 0u;
+        for(const auto* pRecord : records)
+        {
+            auto& write = writes.emplace_back();
+            write.setDescriptorType(pRecord->Type);
+            write.setDstSet(newSet);
+            write.setDstBinding(pRecord->Binding);
+            write.setDstArrayElement(pRecord->ArrayElement);
+            write.setDescriptorCount(1);
+            if(pRecord->pBuffer != nullptr)
+                write.setPBufferInfo(&bufferInfos[bufferIndex++]);
+            else
+                write.setPImageInfo(&imageInfos[imageIndex++]);
+        }
+        if(!writes.empty() || !copies.empty())
+            m_ctx->GetDevice().updateDescriptorSets(writes, copies);
+        m_set = newSet;
+    }
+
 } // namespace VkMana
\ No newline at end of file
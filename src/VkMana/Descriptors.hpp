@@ -4,6 +4,9 @@
 #include "Image.hpp"
 #include "VulkanCommon.hpp"
 
+#include <unordered_set>
+#include <vector>
+
 namespace VkMana
 {
     class Context;
@@ -15,9 +18,16 @@ namespace VkMana
         uint32_t count = 1;
         vk::ShaderStageFlags stageFlags;
         vk::DescriptorBindingFlags bindingFlags;
+
+        bool operator==(const SetLayoutBinding&) const = default;
+    };
+    struct SetLayoutBindingsHash
+    {
+        auto operator()(const std::vector<SetLayoutBinding>& bindings) const -> size_t;
     };
 
-    class SetLayout : public IntrusivePtrEnabled<SetLayout>
+    // Cached by Context::CreateSetLayout, so handles are shared between threads.
+    class SetLayout : public ThreadSafeIntrusivePtrEnabled<SetLayout>
     {
     public:
         ~SetLayout();
@@ -40,23 +50,52 @@ namespace VkMana
     class DescriptorSet : public IntrusivePtrEnabled<DescriptorSet>
     {
     public:
-        ~DescriptorSet() = default;
+        ~DescriptorSet();
 
         void Write(const ImageView* pImage, const Sampler* pSampler, uint32_t binding);
         void Write(uint32_t binding, const Buffer* pBuffer, uint64_t offset, uint64_t range, vk::DescriptorType descriptorType);
 
         void WriteArray(uint32_t binding, uint32_t arrayOffset, const std::vector<const ImageView*>& images, const Sampler* sampler);
+        void WriteStorageArray(uint32_t binding, uint32_t arrayOffset, const std::vector<const ImageView*>& images); // Expects images in General.
 
         auto GetSet() const -> auto { return m_set; }
 
     private:
         friend class Context;
 
-        DescriptorSet(Context* context, vk::DescriptorSet set);
+        DescriptorSet(Context* context, vk::DescriptorSet set, bool isStatic = false, vk::DescriptorSetLayout layout = {});
+
+        struct WriteRecord
+        {
+            uint32_t Binding = 0;
+            uint32_t ArrayElement = 0;
+            vk::DescriptorType Type;
+            const Buffer* pBuffer = nullptr;
+            uint64_t Offset = 0;
+            uint64_t Range = 0;
+            const ImageView* pView = nullptr;
+            const Sampler* pSampler = nullptr;
+            vk::ImageLayout Layout = vk::ImageLayout::eUndefined;
+        };
+        void Record(const WriteRecord& record);
+        void Forget(const Buffer* pBuffer);
+        void Forget(const Image* pImage);
+        void Forget(const ImageView* pView);
+        void Forget(const Sampler* pSampler);
+        bool References(const std::unordered_set<const Buffer*>& buffers, const std::unordered_set<const Image*>& images) const;
+        void EraseReferenced(std::unordered_set<const Buffer*>& buffers, std::unordered_set<const Image*>& images) const; // Keeps what this set doesn't use.
+        /**
+         * Re-write descriptors of resources that were given new handles by defragmentation into newSet, which this set uses from then on.
+         * Other descriptors are copied over. The previous set may still be in use & must be binned by the caller.
+         */
+        void RewriteMoved(vk::DescriptorSet newSet, const std::unordered_set<const Buffer*>& buffers, const std::unordered_set<const Image*>& images);
 
     private:
         Context* m_ctx;
         vk::DescriptorSet m_set;
+        bool m_isStatic;                   // Owned by the set instead of a frame's DescriptorAllocator.
+        std::vector<WriteRecord> m_writes; // Static sets only. Latest write per array element, of resources still alive.
+        vk::DescriptorSetLayout m_layout;  // Static sets only. Cached by the context, so outlives the set.
     };
     using DescriptorSetHandle = IntrusivePtr<DescriptorSet>;
 
@@ -11,8 +11,9 @@ namespace VkMana
 {
     class Context;
 
+    // Resources may be created & uploaded on worker threads (see UploadContext), so they are reference counted atomically.
     template <typename T>
-    class GPUResource : public IntrusivePtrEnabled<T>
+    class GPUResource : public ThreadSafeIntrusivePtrEnabled<T>
     {
     public:
         explicit GPUResource(Context* pContext)
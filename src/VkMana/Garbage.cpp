@@ -12,6 +12,8 @@ namespace VkMana
 
     void GarbageBin::Bin(vk::DescriptorSetLayout layout) { m_setLayouts.push_back(layout); }
 
+    void GarbageBin::Bin(vk::DescriptorSet set) { m_descriptorSets.push_back(set); }
+
     void GarbageBin::Bin(vk::PipelineLayout layout) { m_pipelineLayouts.push_back(layout); }
 
     void GarbageBin::Bin(vk::Pipeline pipeline) { m_pipelines.push_back(pipeline); }
@@ -34,6 +36,8 @@ namespace VkMana
             m_ctx->GetDevice().destroy(v);
         for(auto& v : m_fences)
             m_ctx->GetDevice().destroy(v);
+        if(!m_descriptorSets.empty())
+            m_ctx->FreeDescriptorSets(m_descriptorSets);
         for(auto& v : m_setLayouts)
             m_ctx->GetDevice().destroy(v);
         for(auto& v : m_pipelineLayouts)
@@ -55,6 +59,7 @@ namespace VkMana
 
         m_semaphores.clear();
         m_fences.clear();
+        m_descriptorSets.clear();
         m_setLayouts.clear();
         m_pipelineLayouts.clear();
         m_pipelines.clear();
@@ -16,6 +16,7 @@ namespace VkMana
         void Bin(vk::Semaphore semaphore);
         void Bin(vk::Fence fence);
         void Bin(vk::DescriptorSetLayout layout);
+        void Bin(vk::DescriptorSet set);
         void Bin(vk::PipelineLayout layout);
         void Bin(vk::Pipeline pipeline);
         void Bin(vk::Image image);
@@ -37,6 +38,7 @@ namespace VkMana
         std::vector<vk::Semaphore> m_semaphores;
         std::vector<vk::Fence> m_fences;
         std::vector<vk::DescriptorSetLayout> m_setLayouts;
+        std::vector<vk::DescriptorSet> m_descriptorSets;
         std::vector<vk::PipelineLayout> m_pipelineLayouts;
         std::vector<vk::Pipeline> m_pipelines;
         std::vector<vk::Image> m_images;
@@ -0,0 +1,287 @@
+#include "GeometryPool.hpp"
+
+#include "Context.hpp"
+
+#include <algorithm>
+
+namespace VkMana
+{
+    namespace
+    {
+        void TransferWriteBarrier(CmdBuffer& cmd, const Buffer* pVertexBuffer, const Buffer* pIndexBuffer, vk::PipelineStageFlags2 dstStages, vk::AccessFlags2 dstAccess)
+        {
+            std::vector<BufferBarrierInfo> barriers;
+            for(const auto* pBuffer : { pVertexBuffer, pIndexBuffer })
+            {
+                barriers.push_back({
+                    .pBuffer = pBuffer,
+                    .srcStage = vk::PipelineStageFlagBits2::eTransfer,
+                    .srcAccess = vk::AccessFlagBits2::eTransferWrite,
+                    .dstStage = dstStages,
+                    .dstAccess = dstAccess,
+                });
+            }
+            cmd->PipelineBarrier({}, barriers);
+        }
+
+    } // namespace
+
+    GeometryRange::~GeometryRange() { m_pool->Free(this); }
+
+    GeometryRange::GeometryRange(IntrusivePtr<GeometryPool> pool, uint32_t vertexOffset, uint32_t vertexCount, uint32_t indexOffset, uint32_t indexCount)
+        : m_pool(std::move(pool))
+        , m_vertexOffset(vertexOffset)
+        , m_vertexCount(vertexCount)
+        , m_indexOffset(indexOffset)
+        , m_indexCount(indexCount)
+    {
+    }
+
+    auto GeometryPool::New(Context* context, const GeometryPoolCreateInfo& info) -> IntrusivePtr<GeometryPool>
+    {
+        auto pool = IntrusivePtr(new GeometryPool(context, info));
+        if(!pool->CreateBuffers(pool->m_vertexBuffer, pool->m_indexBuffer))
+            return nullptr;
+
+        pool->m_freeVertices.Reset(info.vertexCapacity);
+        pool->m_freeIndices.Reset(info.indexCapacity);
+        return pool;
+    }
+
+    auto GeometryPool::Allocate(uint32_t vertexCount, uint32_t indexCount) -> GeometryRangeHandle
+    {
+        RetireFrees();
+
+        uint32_t vertexOffset = 0;
+        uint32_t indexOffset = 0;
+        if(!m_freeVertices.Allocate(vertexCount, vertexOffset))
+        {
+            VM_ERR("Failed to allocate {} vertices from GeometryPool (Out of space)", vertexCount);
+            return nullptr;
+        }
+        if(!m_freeIndices.Allocate(indexCount, indexOffset))
+        {
+            VM_ERR("Failed to allocate {} indices from GeometryPool (Out of space)", indexCount);
+            m_freeVertices.Free(vertexOffset, vertexCount);
+            return nullptr;
+        }
+
+        auto range = IntrusivePtr(new GeometryRange(ReferenceFromThis(), vertexOffset, vertexCount, indexOffset, indexCount));
+        m_ranges.push_back(range.Get());
+        return range;
+    }
+
+    void GeometryPool::Write(CmdBuffer& cmd, const GeometryRange* pRange, const void* pVertices, const void* pIndices)
+    {
+        if(pVertices != nullptr && pRange->GetVertexCount() != 0)
+        {
+            const uint64_t stride = m_info.vertexStride;
+            m_vertexBuffer->Update(*cmd, pVertices, stride * pRange->GetVertexCount(), stride * pRange->GetVertexOffset());
+        }
+        if(pIndices != nullptr && pRange->GetIndexCount() != 0)
+        {
+            const uint64_t indexSize = GetIndexSize();
+            m_indexBuffer->Update(*cmd, pIndices, indexSize * pRange->GetIndexCount(), indexSize * pRange->GetIndexOffset());
+        }
+
+        const auto dstStages = vk::PipelineStageFlagBits2::eVertexAttributeInput | vk::PipelineStageFlagBits2::eIndexInput;
+        const auto dstAccess = vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead;
+        TransferWriteBarrier(cmd, m_vertexBuffer.Get(), m_indexBuffer.Get(), dstStages, dstAccess);
+    }
+
+    auto GeometryPool::Upload(const GeometryRange* pRange, const void* pVertices, const void* pIndices) -> SyncPoint
+    {
+        auto cmd = m_ctx->RequestCmd();
+        Write(cmd, pRange, pVertices, pIndices);
+        return m_ctx->Submit(cmd);
+    }
+
+    bool GeometryPool::Defragment(CmdBuffer& cmd)
+    {
+        // Already compact if every live range is packed at the start of both spaces.
+        const auto stats = GetStats();
+        const bool verticesCompact = stats.FreeVertexRangeCount == 0 || (stats.FreeVertexRangeCount == 1 && m_freeVertices.Ranges[0].Offset == stats.UsedVertexCount);
+        const bool indicesCompact = stats.FreeIndexRangeCount == 0 || (stats.FreeIndexRangeCount == 1 && m_freeIndices.Ranges[0].Offset == stats.UsedIndexCount);
+        if(verticesCompact && indicesCompact && m_pendingFrees.empty())
+            return false;
+
+        // Copy into new buffers, vkCmdCopyBuffer regions must not overlap within one buffer.
+        BufferHandle vertexBuffer;
+        BufferHandle indexBuffer;
+        if(!CreateBuffers(vertexBuffer, indexBuffer))
+            return false;
+
+        // Writes recorded before this (e.g. by Write) must land before they are copied out.
+        TransferWriteBarrier(cmd, m_vertexBuffer.Get(), m_indexBuffer.Get(), vk::PipelineStageFlagBits2::eTransfer, vk::AccessFlagBits2::eTransferRead);
+
+        // Keep the relative order of ranges, so ranges that are already in place stay contiguous.
+        auto ranges = m_ranges;
+        std::sort(ranges.begin(), ranges.end(), [](const auto* a, const auto* b) { return a->GetVertexOffset() < b->GetVertexOffset(); });
+
+        const uint64_t stride = m_info.vertexStride;
+        const uint64_t indexSize = GetIndexSize();
+        std::vector<vk::BufferCopy> vertexRegions;
+        std::vector<vk::BufferCopy> indexRegions;
+        uint32_t vertexOffset = 0;
+        uint32_t indexOffset = 0;
+        for(auto* pRange : ranges)
+        {
+            if(pRange->m_vertexCount != 0)
+                vertexRegions.emplace_back(stride * pRange->m_vertexOffset, stride * vertexOffset, stride * pRange->m_vertexCount);
+            if(pRange->m_indexCount != 0)
+                indexRegions.emplace_back(indexSize * pRange->m_indexOffset, indexSize * indexOffset, indexSize * pRange->m_indexCount);
+
+            pRange->m_vertexOffset = vertexOffset;
+            pRange->m_indexOffset = indexOffset;
+            vertexOffset += pRange->m_vertexCount;
+            indexOffset += pRange->m_indexCount;
+        }
+        if(!vertexRegions.empty())
+            cmd->GetCmd().copyBuffer(m_vertexBuffer->GetBuffer(), vertexBuffer->GetBuffer(), vertexRegions);
+        if(!indexRegions.empty())
+            cmd->GetCmd().copyBuffer(m_indexBuffer->GetBuffer(), indexBuffer->GetBuffer(), indexRegions);
+
+        const auto dstStages = vk::PipelineStageFlagBits2::eVertexAttributeInput | vk::PipelineStageFlagBits2::eIndexInput | vk::PipelineStageFlagBits2::eTransfer;
+        const auto dstAccess = vk::AccessFlagBits2::eVertexAttributeRead | vk::AccessFlagBits2::eIndexRead | vk::AccessFlagBits2::eTransferWrite;
+        TransferWriteBarrier(cmd, vertexBuffer.Get(), indexBuffer.Get(), dstStages, dstAccess);
+
+        // The old buffers are binned & destroyed once this frame has completed.
+        // Pending frees referred to the old buffers, so they are dropped with them.
+        m_vertexBuffer = std::move(vertexBuffer);
+        m_indexBuffer = std::move(indexBuffer);
+        m_freeVertices.Reset(m_info.vertexCapacity, vertexOffset);
+        m_freeIndices.Reset(m_info.indexCapacity, indexOffset);
+        m_pendingFrees.clear();
+        return true;
+    }
+
+    void GeometryPool::Bind(CmdBuffer& cmd, uint32_t vertexBinding) const
+    {
+        cmd->BindIndexBuffer(m_indexBuffer.Get(), 0, m_info.indexType);
+        cmd->BindVertexBuffers(vertexBinding, { m_vertexBuffer.Get() }, { 0 });
+    }
+
+    auto GeometryPool::GetStats() const -> GeometryPoolStats
+    {
+        GeometryPoolStats stats{};
+        for(const auto* pRange : m_ranges)
+        {
+            stats.UsedVertexCount += pRange->GetVertexCount();
+            stats.UsedIndexCount += pRange->GetIndexCount();
+        }
+        stats.FreeVertexRangeCount = uint32_t(m_freeVertices.Ranges.size());
+        stats.FreeIndexRangeCount = uint32_t(m_freeIndices.Ranges.size());
+        for(const auto& range : m_freeVertices.Ranges)
+            stats.LargestFreeVertexRange = std::max(stats.LargestFreeVertexRange, range.Count);
+        for(const auto& range : m_freeIndices.Ranges)
+            stats.LargestFreeIndexRange = std::max(stats.LargestFreeIndexRange, range.Count);
+        return stats;
+    }
+
+    GeometryPool::GeometryPool(Context* context, const GeometryPoolCreateInfo& info)
+        : m_ctx(context)
+        , m_info(info)
+    {
+    }
+
+    bool GeometryPool::CreateBuffers(BufferHandle& outVertexBuffer, BufferHandle& outIndexBuffer) const
+    {
+        auto vertexInfo = BufferCreateInfo::Vertex(uint64_t(m_info.vertexStride) * m_info.vertexCapacity);
+        vertexInfo.usage |= vk::BufferUsageFlagBits::eTransferSrc;
+        auto indexInfo = BufferCreateInfo::Index(uint64_t(GetIndexSize()) * m_info.indexCapacity);
+        indexInfo.usage |= vk::BufferUsageFlagBits::eTransferSrc;
+
+        outVertexBuffer = m_ctx->CreateBuffer(vertexInfo);
+        outIndexBuffer = m_ctx->CreateBuffer(indexInfo);
+        if(outVertexBuffer == nullptr || outIndexBuffer == nullptr)
+        {
+            VM_ERR("Failed to create GeometryPool buffers");
+            return false;
+        }
+        outVertexBuffer->SetDebugName("GeometryPool Vertices");
+        outIndexBuffer->SetDebugName("GeometryPool Indices");
+        return true;
+    }
+
+    void GeometryPool::Free(const GeometryRange* pRange)
+    {
+        std::erase(m_ranges, pRange);
+
+        // Frames still in flight may read the range, so it can only be reused once they have completed.
+        m_pendingFrees.push_back({
+            .VertexOffset = pRange->GetVertexOffset(),
+            .VertexCount = pRange->GetVertexCount(),
+            .IndexOffset = pRange->GetIndexOffset(),
+            .IndexCount = pRange->GetIndexCount(),
+            .FrameNumber = m_ctx->GetFrameNumber(),
+        });
+    }
+
+    void GeometryPool::RetireFrees()
+    {
+        const auto frameNumber = m_ctx->GetFrameNumber();
+        const auto frameCount = m_ctx->GetFrameBufferCount();
+        std::erase_if(m_pendingFrees, [&](const auto& pending) {
+            // The frame's slot has been waited on once it has been begun again.
+            if(frameNumber < pending.FrameNumber + frameCount)
+                return false;
+
+            m_freeVertices.Free(pending.VertexOffset, pending.VertexCount);
+            m_freeIndices.Free(pending.IndexOffset, pending.IndexCount);
+            return true;
+        });
+    }
+
+    auto GeometryPool::GetIndexSize() const -> uint32_t { return m_info.indexType == vk::IndexType::eUint32 ? 4 : 2; }
+
+    void GeometryPool::FreeList::Reset(uint32_t capacity, uint32_t used)
+    {
+        Ranges.clear();
+        if(used < capacity)
+            Ranges.push_back({ used, capacity - used });
+    }
+
+    bool GeometryPool::FreeList::Allocate(uint32_t count, uint32_t& outOffset)
+    {
+        outOffset = 0;
+        if(count == 0)
+            return true;
+
+        const auto it = std::find_if(Ranges.begin(), Ranges.end(), [count](const auto& range) { return range.Count >= count; });
+        if(it == Ranges.end())
+            return false;
+
+        outOffset = it->Offset;
+        it->Offset += count;
+        it->Count -= count;
+        if(it->Count == 0)
+            Ranges.erase(it);
+        return true;
+    }
+
+    void GeometryPool::FreeList::Free(uint32_t offset, uint32_t count)
+    {
+        if(count == 0)
+            return;
+
+        auto it = std::lower_bound(Ranges.begin(), Ranges.end(), offset, [](const auto& range, uint32_t value) { return range.Offset < value; });
+        it = Ranges.insert(it, { offset, count });
+
+        // Merge with the next range, then the previous one.
+        if(auto next = it + 1; next != Ranges.end() && it->Offset + it->Count == next->Offset)
+        {
+            it->Count += next->Count;
+            it = Ranges.erase(next) - 1;
+        }
+        if(it != Ranges.begin())
+        {
+            auto prev = it - 1;
+            if(prev->Offset + prev->Count == it->Offset)
+            {
+                prev->Count += it->Count;
+                Ranges.erase(it);
+            }
+        }
+    }
+
+} // namespace VkMana
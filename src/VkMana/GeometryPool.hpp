@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandBuffer.hpp"
+#include "VulkanCommon.hpp"
+
+#include <vector>
+
+namespace VkMana
+{
+    class Context;
+    class GeometryPool;
+
+    struct GeometryPoolCreateInfo
+    {
+        uint32_t vertexStride = 0;
+        uint32_t vertexCapacity = 0; // In vertices.
+        uint32_t indexCapacity = 0;  // In indices.
+        vk::IndexType indexType = vk::IndexType::eUint16;
+    };
+
+    struct GeometryPoolStats
+    {
+        uint32_t UsedVertexCount = 0;
+        uint32_t UsedIndexCount = 0;
+        uint32_t FreeVertexRangeCount = 0; // More than one means the vertex space is fragmented.
+        uint32_t FreeIndexRangeCount = 0;
+        uint32_t LargestFreeVertexRange = 0;
+        uint32_t LargestFreeIndexRange = 0;
+    };
+
+    /**
+     * Vertex & index ranges sub-allocated from a GeometryPool. Returned to the pool once released.
+     * Offsets are in vertices/indices & may change when the pool is defragmented.
+     * Draw with firstIndex = GetIndexOffset() + ... & vertexOffset = GetVertexOffset() + ...
+     */
+    class GeometryRange : public IntrusivePtrEnabled<GeometryRange>
+    {
+    public:
+        ~GeometryRange();
+
+        auto GetVertexOffset() const -> auto { return m_vertexOffset; }
+        auto GetVertexCount() const -> auto { return m_vertexCount; }
+        auto GetIndexOffset() const -> auto { return m_indexOffset; }
+        auto GetIndexCount() const -> auto { return m_indexCount; }
+
+    private:
+        friend class GeometryPool;
+
+        GeometryRange(IntrusivePtr<GeometryPool> pool, uint32_t vertexOffset, uint32_t vertexCount, uint32_t indexOffset, uint32_t indexCount);
+
+    private:
+        IntrusivePtr<GeometryPool> m_pool;
+        uint32_t m_vertexOffset;
+        uint32_t m_vertexCount;
+        uint32_t m_indexOffset;
+        uint32_t m_indexCount;
+    };
+    using GeometryRangeHandle = IntrusivePtr<GeometryRange>;
+
+    /**
+     * One large vertex buffer & one large index buffer that meshes sub-allocate ranges from,
+     * so a single bind covers every mesh in the pool (e.g. for multi-draw & indirect draws).
+     * Released ranges are reused once the frames that may still read them have completed.
+     * Not thread-safe.
+     */
+    class GeometryPool : public IntrusivePtrEnabled<GeometryPool>
+    {
+    public:
+        static auto New(Context* context, const GeometryPoolCreateInfo& info) -> IntrusivePtr<GeometryPool>;
+
+        ~GeometryPool() = default;
+
+        auto Allocate(uint32_t vertexCount, uint32_t indexCount) -> GeometryRangeHandle; // Null if either space has no large enough free range.
+
+        /**
+         * Record writes of the range's vertices & indices (either may be null), followed by a barrier to vertex input.
+         * Must be recorded outside of a render pass.
+         */
+        void Write(CmdBuffer& cmd, const GeometryRange* pRange, const void* pVertices, const void* pIndices);
+        auto Upload(const GeometryRange* pRange, const void* pVertices, const void* pIndices) -> SyncPoint; // Write & submit on the graphics queue.
+
+        /**
+         * Compacts all live ranges to the start of new buffers & updates their offsets. Released ranges become free immediately.
+         * The previous buffers are destroyed once this frame has completed. Rebind the pool & re-read range offsets afterwards.
+         * Submit before any other work that uses the pool. Returns false if there was nothing to compact.
+         */
+        bool Defragment(CmdBuffer& cmd);
+
+        void Bind(CmdBuffer& cmd, uint32_t vertexBinding = 0) const;
+
+        auto GetVertexBuffer() const -> auto { return m_vertexBuffer.Get(); }
+        auto GetIndexBuffer() const -> auto { return m_indexBuffer.Get(); }
+        auto GetIndexType() const -> auto { return m_info.indexType; }
+        auto GetStats() const -> GeometryPoolStats;
+
+    private:
+        friend class GeometryRange;
+
+        GeometryPool(Context* context, const GeometryPoolCreateInfo& info);
+
+        bool CreateBuffers(BufferHandle& outVertexBuffer, BufferHandle& outIndexBuffer) const;
+        void Free(const GeometryRange* pRange);
+        void RetireFrees();
+        auto GetIndexSize() const -> uint32_t;
+
+    private:
+        /* First-fit free list over [0, Capacity), kept sorted by offset. */
+        struct FreeList
+        {
+            struct Range
+            {
+                uint32_t Offset = 0;
+                uint32_t Count = 0;
+            };
+            std::vector<Range> Ranges;
+
+            void Reset(uint32_t capacity, uint32_t used = 0);
+            bool Allocate(uint32_t count, uint32_t& outOffset);
+            void Free(uint32_t offset, uint32_t count); // Merges with neighbouring free ranges.
+        };
+
+        struct PendingFree
+        {
+            uint32_t VertexOffset = 0;
+            uint32_t VertexCount = 0;
+            uint32_t IndexOffset = 0;
+            uint32_t IndexCount = 0;
+            uint64_t FrameNumber = 0; // Context frame the range was released in.
+        };
+
+        Context* m_ctx;
+        GeometryPoolCreateInfo m_info;
+        BufferHandle m_vertexBuffer;
+        BufferHandle m_indexBuffer;
+
+        FreeList m_freeVertices;
+        FreeList m_freeIndices;
+        std::vector<PendingFree> m_pendingFrees;
+        std::vector<GeometryRange*> m_ranges; // Live ranges, updated on defragmentation.
+    };
+    using GeometryPoolHandle = IntrusivePtr<GeometryPool>;
+
+} // namespace VkMana
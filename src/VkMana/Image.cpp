@@ -10,16 +10,40 @@ namespace VkMana
         if(actualMipLevels == -1)
             actualMipLevels = int32_t(std::floor(std::log2(std::max(info.width, info.height)))) + 1;
 
+        auto flags = info.flags;
+        auto usage = info.usage;
+        if(flags & ImageCreateFlags_GenMipMapsCompute)
+        {
+            if(pContext->SupportsComputeMipMaps(info.format))
+                usage |= vk::ImageUsageFlagBits::eStorage;
+            else
+                flags = (flags & ~ImageCreateFlags_GenMipMapsCompute) | ImageCreateFlags_GenMipMaps; // Blit fallback
+        }
+
+        const auto transientUsage
+            = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eInputAttachment;
+        if(flags & ImageCreateFlags_Transient)
+        {
+            if(usage & ~transientUsage)
+            {
+                VM_ERR("Transient images can only be used as attachments");
+                return nullptr;
+            }
+            usage |= vk::ImageUsageFlagBits::eTransientAttachment;
+        }
+
         vk::ImageCreateInfo imageInfo{};
-        imageInfo.setExtent({ info.width, info.height, info.depthOrArrayLayers });
+        imageInfo.setExtent({ info.width, info.height, 1 }); // 2D only, so depthOrArrayLayers are layers.
         imageInfo.setMipLevels(uint32_t(actualMipLevels));
         imageInfo.setArrayLayers(info.depthOrArrayLayers);
         imageInfo.setFormat(info.format);
-        imageInfo.setUsage(info.usage);
+        imageInfo.setUsage(usage);
         imageInfo.setImageType(vk::ImageType::e2D);        // #TODO: Make auto.
         imageInfo.setSamples(vk::SampleCountFlagBits::e1); // #TODO: Make optional.
 
         vma::AllocationCreateInfo allocInfo{};
+        if((flags & ImageCreateFlags_Transient) && pContext->GetGPUInfo().SupportsLazilyAllocatedMemory)
+            allocInfo.setUsage(vma::MemoryUsage::eGpuLazilyAllocated);
 
         auto [image, allocation] = pContext->GetAllocator().createImage(imageInfo, allocInfo);
         if(image == nullptr || !allocation)
@@ -28,18 +52,103 @@ namespace VkMana
             return nullptr;
         }
 
-        auto pNewImage = IntrusivePtr(new Image(pContext, image, allocation, info.width, info.height, info.depthOrArrayLayers, actualMipLevels, info.format));
+        auto pNewImage = IntrusivePtr(new Image(pContext, image, allocation, info.width, info.height, info.depthOrArrayLayers, actualMipLevels, info.format, flags));
+
+        const auto attachmentUsage = vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eDepthStencilAttachment;
+        pNewImage->m_memoryCategory = (usage & attachmentUsage) ? MemoryCategory::RenderTarget : MemoryCategory::Texture;
+        pNewImage->m_allocationSize = pContext->GetAllocator().getAllocationInfo(allocation).size;
+        pNewImage->m_usage = usage;
+        pNewImage->m_createInfo = imageInfo;
+        pContext->AddMemoryUsage(pNewImage->m_memoryCategory, pNewImage->m_allocationSize);
+        // Moves are copies. Render target layouts are not known between frames.
+        const auto transferUsage = vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+        if(pNewImage->m_memoryCategory == MemoryCategory::Texture && (usage & transferUsage) == transferUsage)
+            pContext->RegisterMovable(allocation, nullptr, pNewImage.Get());
         // #TODO: Auto create image views from info.Usage
         return pNewImage;
     }
 
+    auto Image::NewAliased(Context* pContext, const std::vector<ImageCreateInfo>& infos) -> std::vector<IntrusivePtr<Image>>
+    {
+        if(infos.empty())
+            return {};
+
+        auto device = pContext->GetDevice();
+        std::vector<vk::Image> images;
+        vk::MemoryRequirements memoryReqs{ 0, 1, ~0u };
+        for(const auto& info : infos)
+        {
+            if(info.mipLevels == -1 || (info.flags & (ImageCreateFlags_GenMipMaps | ImageCreateFlags_GenMipMapsCompute)))
+                VM_WARN("Aliased images are render targets, mips are not generated");
+
+            vk::ImageCreateInfo imageInfo{};
+            imageInfo.setExtent({ info.width, info.height, 1 });
+            imageInfo.setMipLevels(uint32_t(std::max(info.mipLevels, 1)));
+            imageInfo.setArrayLayers(info.depthOrArrayLayers);
+            imageInfo.setFormat(info.format);
+            imageInfo.setUsage(info.usage);
+            imageInfo.setImageType(vk::ImageType::e2D);
+            imageInfo.setSamples(vk::SampleCountFlagBits::e1);
+            images.push_back(device.createImage(imageInfo));
+
+            const auto reqs = device.getImageMemoryRequirements(images.back());
+            memoryReqs.size = std::max(memoryReqs.size, reqs.size);
+            memoryReqs.alignment = std::max(memoryReqs.alignment, reqs.alignment);
+            memoryReqs.memoryTypeBits &= reqs.memoryTypeBits;
+        }
+
+        vma::Allocation allocation{};
+        if(memoryReqs.memoryTypeBits != 0)
+        {
+            vma::AllocationCreateInfo allocInfo{};
+            allocInfo.setRequiredFlags(vk::MemoryPropertyFlagBits::eDeviceLocal);
+            allocation = pContext->GetAllocator().allocateMemory(memoryReqs, allocInfo);
+        }
+        if(!allocation)
+        {
+            VM_ERR("Failed to allocate memory for aliased Images");
+            for(auto image : images)
+                device.destroy(image);
+            return {};
+        }
+
+        std::vector<IntrusivePtr<Image>> aliasedImages;
+        for(auto i = 0u; i < infos.size(); ++i)
+        {
+            const auto& info = infos[i];
+            pContext->GetAllocator().bindImageMemory(allocation, images[i]);
+
+            // The first image owns the allocation, the others keep it alive.
+            auto pImage = IntrusivePtr(new Image(
+                pContext, images[i], i == 0 ? allocation : nullptr, info.width, info.height, info.depthOrArrayLayers, std::max(info.mipLevels, 1), info.format, 0
+            ));
+            pImage->m_memoryCategory = MemoryCategory::RenderTarget;
+            pImage->m_usage = info.usage;
+            if(i == 0)
+            {
+                pImage->m_allocationSize = pContext->GetAllocator().getAllocationInfo(allocation).size;
+                pImage->m_hasAliases = infos.size() > 1;
+                pContext->AddMemoryUsage(pImage->m_memoryCategory, pImage->m_allocationSize);
+            }
+            else
+                pImage->m_aliasOwner = aliasedImages.front();
+            aliasedImages.push_back(pImage);
+        }
+        return aliasedImages;
+    }
+
     Image::~Image()
     {
+        GetContext()->ForgetStaticDescriptors(this);
         if(m_image && m_ownsImage)
             GetContext()->DestroyImage(m_image);
 
         if(m_allocation)
-            GetContext()->DestroyAllocation(m_allocation);
+        {
+            GetContext()->RemoveMemoryUsage(m_memoryCategory, m_allocationSize);
+            if(!GetContext()->ReleaseMovable(m_allocation))
+                GetContext()->DestroyAllocation(m_allocation);
+        }
     }
 
     void Image::SetDebugName(const std::string& name)
@@ -102,7 +211,8 @@ namespace VkMana
         uint32_t height,
         uint32_t depthOrArrayLayers,
         uint32_t mipLevels,
-        vk::Format format
+        vk::Format format,
+        uint32_t flags
     )
         : GPUResource<Image>(context)
         , m_image(image)
@@ -113,7 +223,7 @@ namespace VkMana
         , m_depthOrArrayLayers(depthOrArrayLayers)
         , m_mipLevels(mipLevels)
         , m_format(format)
-
+        , m_flags(flags)
     {
     }
 
@@ -127,11 +237,15 @@ namespace VkMana
         , m_depthOrArrayLayers(1)
         , m_mipLevels(1)
         , m_format(format)
+        , m_flags(0)
     {
     }
 
     ImageView::~ImageView()
     {
+        m_ctx->ForgetStaticDescriptors(this);
+        if(m_tracked)
+            m_ctx->UntrackImageView(this);
         if(m_view)
             m_ctx->DestroyImageView(m_view);
     }
@@ -146,6 +260,7 @@ namespace VkMana
 
     Sampler::~Sampler()
     {
+        m_ctx->ForgetStaticDescriptors(this);
         if(m_sampler)
             m_ctx->DestroySampler(m_sampler);
     }
@@ -2,7 +2,10 @@
 
 #include "VulkanCommon.hpp"
 
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <vector>
 
 namespace VkMana
 {
@@ -13,6 +16,8 @@ namespace VkMana
     using ImageViewHandle = IntrusivePtr<ImageView>;
 
     constexpr auto ImageCreateFlags_GenMipMaps = (1 << 0);
+    constexpr auto ImageCreateFlags_GenMipMapsCompute = (1 << 1); // Generate mips with a compute shader. Falls back to blits if the format can't be a storage image.
+    constexpr auto ImageCreateFlags_Transient = (1 << 2); // Attachment that is never stored or sampled. Lazily allocated where supported, so tile-based GPUs may never back it with memory.
 
     struct ImageCreateInfo
     {
@@ -44,6 +49,17 @@ namespace VkMana
                 .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment | vk::ImageUsageFlagBits::eSampled,
             };
         }
+        static auto TransientDepthStencilTarget(uint32_t width, uint32_t height, bool use32Bit) -> ImageCreateInfo
+        {
+            return ImageCreateInfo{
+                .width = width,
+                .height = height,
+                .mipLevels = 1,
+                .format = use32Bit ? vk::Format::eD32SfloatS8Uint : vk::Format::eD24UnormS8Uint,
+                .usage = vk::ImageUsageFlagBits::eDepthStencilAttachment,
+                .flags = ImageCreateFlags_Transient,
+            };
+        }
         static auto Texture(uint32_t width, uint32_t height, int32_t mipLevels = -1) -> ImageCreateInfo
         {
             return ImageCreateInfo{
@@ -56,10 +72,25 @@ namespace VkMana
             };
         }
     };
+    struct ImageSubresourceData
+    {
+        uint32_t mipLevel = 0;
+        uint32_t arrayLayer = 0;
+        uint64_t offset = 0;      // Into ImageDataSource::data.
+        uint32_t rowLength = 0;   // In texels. 0 = Tightly packed.
+        uint32_t imageHeight = 0; // In texels. 0 = Tightly packed.
+    };
     struct ImageDataSource
     {
         uint64_t size = 0;
         const void* data = nullptr;
+        std::vector<ImageSubresourceData> subresources; // Empty = data is mip 0 of layer 0.
+
+        // Pre-built mips are uploaded as they are, instead of being generated on the GPU.
+        bool HasMipChain() const
+        {
+            return std::any_of(subresources.begin(), subresources.end(), [](const auto& subresource) { return subresource.mipLevel > 0; });
+        }
     };
 
     struct ImageViewCreateInfo
@@ -90,6 +121,12 @@ namespace VkMana
     {
     public:
         static auto New(Context* pContext, const ImageCreateInfo& info) -> IntrusivePtr<Image>;
+        /**
+         * Images that share one allocation, for render targets whose lifetimes within a frame don't overlap.
+         * Contents are undefined whenever another alias has been used, so each use must start from the Undefined layout.
+         * Transitions from Undefined wait for all previous work, which orders each alias after the last use of the others.
+         */
+        static auto NewAliased(Context* pContext, const std::vector<ImageCreateInfo>& infos) -> std::vector<IntrusivePtr<Image>>;
 
         ~Image() override;
 
@@ -103,10 +140,18 @@ namespace VkMana
         auto GetDepthOrArrayLayers() const -> auto { return m_depthOrArrayLayers; }
         auto GetMipLevels() const -> auto { return m_mipLevels; }
         auto GetFormat() const -> auto { return m_format; }
+        auto GetFlags() const -> auto { return m_flags; }
+        auto GetUsage() const -> auto { return m_usage; }
+        auto GetMemoryCategory() const -> auto { return m_memoryCategory; }
         auto GetAspect() const -> vk::ImageAspectFlags;
+        bool IsAliased() const { return m_aliasOwner != nullptr || m_hasAliases; }
+        // Every level, as of the last barrier recorded by a CommandBuffer.
+        bool IsShaderReadOnly() const { return m_shaderReadMips.load() == uint32_t((uint64_t(1) << m_mipLevels) - 1); }
 
     private:
         friend class SwapChain;
+        friend class Context;
+        friend class CommandBuffer;
 
         Image(
             Context* context,
@@ -116,7 +161,8 @@ namespace VkMana
             uint32_t height,
             uint32_t depthOrArrayLayers,
             uint32_t mipLevels,
-            vk::Format format
+            vk::Format format,
+            uint32_t flags
         );
         Image(Context* context, vk::Image image, uint32_t width, uint32_t height, vk::Format format);
 
@@ -130,6 +176,14 @@ namespace VkMana
         uint32_t m_depthOrArrayLayers;
         uint32_t m_mipLevels;
         vk::Format m_format;
+        uint32_t m_flags;
+        vk::ImageUsageFlags m_usage;
+        MemoryCategory m_memoryCategory = MemoryCategory::Texture;
+        uint64_t m_allocationSize = 0;
+        IntrusivePtr<Image> m_aliasOwner = nullptr; // Owns the allocation shared with this image.
+        bool m_hasAliases = false;
+        vk::ImageCreateInfo m_createInfo; // As created by Image::New, so defragmentation can recreate the image.
+        mutable std::atomic_uint32_t m_shaderReadMips{ 0 }; // Levels last transitioned to ShaderReadOnly (all layers) on the graphics queue family.
 
         std::array<ImageViewHandle, uint8_t(ImageViewType::Count)> m_views;
     };
@@ -153,6 +207,7 @@ namespace VkMana
         const Image* m_image;
         vk::ImageView m_view;
         ImageViewCreateInfo m_info;
+        bool m_tracked = false; // Recreated when defragmentation moves the image.
     };
 
     class Sampler : public IntrusivePtrEnabled<Sampler>
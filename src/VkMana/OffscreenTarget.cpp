@@ -0,0 +1,143 @@
+#include "OffscreenTarget.hpp"
+
+#include "Context.hpp"
+
+#include <fstream>
+
+namespace VkMana
+{
+    namespace
+    {
+        bool FormatIsRGBA8(vk::Format format)
+        {
+            switch(format)
+            {
+            case vk::Format::eR8G8B8A8Unorm:
+            case vk::Format::eR8G8B8A8Srgb:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        bool FormatIsBGRA8(vk::Format format)
+        {
+            switch(format)
+            {
+            case vk::Format::eB8G8R8A8Unorm:
+            case vk::Format::eB8G8R8A8Srgb:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+    } // namespace
+
+    auto OffscreenTarget::New(Context* pContext, uint32_t width, uint32_t height, vk::Format format) -> IntrusivePtr<OffscreenTarget>
+    {
+        if(!FormatIsRGBA8(format) && !FormatIsBGRA8(format))
+        {
+            VM_ERR("Failed to create OffscreenTarget (Unsupported format {})", vk::to_string(format));
+            return nullptr;
+        }
+
+        auto imageInfo = ImageCreateInfo::ColorTarget(width, height, format);
+        imageInfo.usage |= vk::ImageUsageFlagBits::eTransferSrc;
+
+        std::vector<ImageHandle> images(pContext->GetFrameBufferCount());
+        for(auto i = 0u; i < images.size(); ++i)
+        {
+            images[i] = pContext->CreateImage(imageInfo);
+            if(images[i] == nullptr)
+            {
+                VM_ERR("Failed to create OffscreenTarget (Image {} was not created)", i);
+                return nullptr;
+            }
+            images[i]->SetDebugName("OffscreenTarget " + std::to_string(i));
+        }
+
+        return IntrusivePtr(new OffscreenTarget(pContext, width, height, format, images));
+    }
+
+    auto OffscreenTarget::Readback() -> std::vector<uint8_t>
+    {
+        auto readback = ReadbackAsync();
+        if(readback == nullptr)
+            return {};
+
+        m_pContext->Wait(readback->GetSyncPoint());
+        readback->IsReady();
+        return readback->GetData();
+    }
+
+    auto OffscreenTarget::ReadbackAsync() -> ReadbackHandle
+    {
+        auto cmd = m_pContext->RequestCmd();
+        auto readback = cmd->ReadbackImage(GetImage());
+        m_pContext->Submit(cmd);
+        return readback;
+    }
+
+    bool OffscreenTarget::SaveToFile(const std::string& filename)
+    {
+        const auto pixels = Readback();
+        if(pixels.size() < uint64_t(m_width) * m_height * 4)
+        {
+            VM_ERR("Failed to save OffscreenTarget to {} (Readback failed)", filename);
+            return false;
+        }
+
+        std::ofstream file(filename, std::ios::binary);
+        if(!file)
+        {
+            VM_ERR("Failed to open file for writing: {}", filename);
+            return false;
+        }
+
+        file << "P6\n" << m_width << " " << m_height << "\n255\n";
+
+        const auto redIndex = FormatIsBGRA8(m_format) ? 2 : 0;
+        const auto blueIndex = FormatIsBGRA8(m_format) ? 0 : 2;
+        std::vector<uint8_t> rgb(uint64_t(m_width) * m_height * 3);
+        for(auto i = 0ull; i < uint64_t(m_width) * m_height; ++i)
+        {
+            rgb[i * 3 + 0] = pixels[i * 4 + redIndex];
+            rgb[i * 3 + 1] = pixels[i * 4 + 1];
+            rgb[i * 3 + 2] = pixels[i * 4 + blueIndex];
+        }
+        file.write(reinterpret_cast<const char*>(rgb.data()), std::streamsize(rgb.size()));
+
+        return file.good();
+    }
+
+    auto OffscreenTarget::GetImage() const -> const Image* { return m_images.at(m_pContext->GetFrameIndex()).Get(); }
+
+    auto OffscreenTarget::GetRenderPass() -> RenderPassInfo
+    {
+        RenderPassInfo renderPassInfo{
+            .targets = {
+                RenderPassTarget{
+                    .pImage = m_images.at(m_pContext->GetFrameIndex())->GetImageView(ImageViewType::RenderTarget),
+                    .isDepthStencil = false,
+                    .clear = true,
+                    .store = true,
+                    .clearValue = { 0.0f, 0.0f, 0.0f, 1.0f },
+                    .preLayout = vk::ImageLayout::eUndefined,
+                    .postLayout = vk::ImageLayout::eTransferSrcOptimal,
+                },
+            },
+        };
+        return renderPassInfo;
+    }
+
+    OffscreenTarget::OffscreenTarget(Context* pContext, uint32_t width, uint32_t height, vk::Format format, const std::vector<ImageHandle>& images)
+        : m_pContext(pContext)
+        , m_images(images)
+        , m_width(width)
+        , m_height(height)
+        , m_format(format)
+    {
+    }
+
+} // namespace VkMana
@@ -0,0 +1,59 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "Image.hpp"
+#include "Readback.hpp"
+#include "RenderPass.hpp"
+
+#include <string>
+
+namespace VkMana
+{
+    class Context;
+
+    /**
+     * Stand-in for a SwapChain when running headless.
+     * Holds one image per frame in flight, so rendering a frame never overwrites an image still being read back.
+     */
+    class OffscreenTarget : public IntrusivePtrEnabled<OffscreenTarget>
+    {
+    public:
+        static auto New(Context* pContext, uint32_t width, uint32_t height, vk::Format format) -> IntrusivePtr<OffscreenTarget>;
+
+        ~OffscreenTarget() = default;
+
+        /**
+         * Copy the current frame's image to host memory. Waits for all graphics work submitted so far.
+         * Returns tightly packed pixels in the target format.
+         */
+        auto Readback() -> std::vector<uint8_t>;
+        auto ReadbackAsync() -> ReadbackHandle; // Submits the copy & returns without waiting. Ready within GetFrameBufferCount() frames.
+        bool SaveToFile(const std::string& filename); // Binary PPM. 8-bit RGBA/BGRA formats only.
+
+#pragma region Getters
+
+        auto GetImage() const -> const Image*;
+
+        auto GetBackBufferWidth() const -> auto { return m_width; }
+        auto GetBackBufferHeight() const -> auto { return m_height; }
+        auto GetBackBufferFormat() const -> auto { return m_format; }
+
+        auto GetRenderPass() -> RenderPassInfo;
+
+#pragma endregion
+
+    private:
+        OffscreenTarget(Context* pContext, uint32_t width, uint32_t height, vk::Format format, const std::vector<ImageHandle>& images);
+
+    private:
+        Context* m_pContext = nullptr;
+        std::vector<ImageHandle> m_images; // Per frame in flight.
+
+        uint32_t m_width;
+        uint32_t m_height;
+        vk::Format m_format;
+    };
+
+    using OffscreenTargetHandle = IntrusivePtr<OffscreenTarget>;
+
+} // namespace VkMana
@@ -4,32 +4,29 @@
 
 namespace VkMana
 {
-    auto PipelineLayout::New(Context* pContext, const PipelineLayoutCreateInfo& info) -> IntrusivePtr<PipelineLayout>
+    auto PipelineLayoutKeyHash::operator()(const PipelineLayoutKey& key) const -> size_t
     {
         size_t hash = 0;
-        HashCombine(hash, info.PushConstantRange);
+        HashCombine(hash, key.PushConstantRange);
+        for(const auto& setLayout : key.SetLayouts)
+            HashCombine(hash, setLayout);
+        return hash;
+    }
 
-        std::vector<vk::DescriptorSetLayout> setLayouts(info.SetLayouts.size());
-        for(auto i = 0u; i < info.SetLayouts.size(); ++i)
-        {
-            HashCombine(hash, i);
-            if(info.SetLayouts[i])
-            {
-                HashCombine(hash, info.SetLayouts[i]->GetHash());
-                setLayouts[i] = info.SetLayouts[i]->GetLayout();
-            }
-            else
-                HashCombine(hash, 0);
-        }
+    auto PipelineLayout::New(Context* pContext, const PipelineLayoutCreateInfo& info) -> IntrusivePtr<PipelineLayout>
+    {
+        PipelineLayoutKey key{ info.PushConstantRange };
+        key.SetLayouts.reserve(info.SetLayouts.size());
+        for(const auto* pSetLayout : info.SetLayouts)
+            key.SetLayouts.push_back(pSetLayout ? pSetLayout->GetLayout() : vk::DescriptorSetLayout());
 
-        // #TODO: Layout caching. e.g.
-        // 	PipelineLayoutHandle cachedLayout = pContext->FindCachedPipelineLayout(hash)?
-        // 	if(cachedLayout != nullptr) return cachedLayout;
+        if(auto cachedLayout = pContext->FindCachedPipelineLayout(key))
+            return cachedLayout;
 
         vk::PipelineLayoutCreateInfo layoutInfo{};
         if(info.PushConstantRange.size > 0)
             layoutInfo.setPushConstantRanges(info.PushConstantRange);
-        layoutInfo.setSetLayouts(setLayouts);
+        layoutInfo.setSetLayouts(key.SetLayouts);
         auto newPipelineLayout = pContext->GetDevice().createPipelineLayout(layoutInfo);
         if(newPipelineLayout == nullptr)
         {
@@ -37,9 +34,8 @@ namespace VkMana
             return nullptr;
         }
 
-        auto pNewPipelineLayout = IntrusivePtr(new PipelineLayout(pContext, newPipelineLayout, hash));
-        // #TODO: pContext->CachePipelineLayout(pNewPipelineLayout);
-        return pNewPipelineLayout;
+        auto pNewPipelineLayout = IntrusivePtr(new PipelineLayout(pContext, newPipelineLayout, PipelineLayoutKeyHash{}(key)));
+        return pContext->CachePipelineLayout(std::move(key), pNewPipelineLayout); // Another thread may have cached an identical layout first.
     }
 
     PipelineLayout::~PipelineLayout()
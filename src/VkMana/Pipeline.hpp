@@ -17,6 +17,19 @@ namespace VkMana
 
     class PipelineLayout;
 
+    // Identity of a cached PipelineLayout. Set layouts are cached for the lifetime of the context, so their handles are never reused.
+    struct PipelineLayoutKey
+    {
+        vk::PushConstantRange PushConstantRange;
+        std::vector<vk::DescriptorSetLayout> SetLayouts;
+
+        bool operator==(const PipelineLayoutKey&) const = default;
+    };
+    struct PipelineLayoutKeyHash
+    {
+        auto operator()(const PipelineLayoutKey& key) const -> size_t;
+    };
+
     using ShaderByteCode = std::vector<uint8_t>;
     struct ShaderByteCodeInfo
     {
@@ -58,7 +71,8 @@ namespace VkMana
         IntrusivePtr<PipelineLayout> pPipelineLayout = nullptr;
     };
 
-    class PipelineLayout : public IntrusivePtrEnabled<PipelineLayout>
+    // Cached by the context, so identical layouts share a handle (& descriptor sets stay bound across pipelines using it).
+    class PipelineLayout : public ThreadSafeIntrusivePtrEnabled<PipelineLayout>
     {
     public:
         static auto New(Context* pContext, const PipelineLayoutCreateInfo& info) -> IntrusivePtr<PipelineLayout>;
@@ -0,0 +1,46 @@
+#include "Readback.hpp"
+
+#include "Context.hpp"
+
+#include <cstring>
+
+namespace VkMana
+{
+    bool Readback::IsReady()
+    {
+        if(m_ready)
+            return true;
+
+        std::lock_guard lock(m_mutex);
+        if(!m_ready && m_submitted && m_ctx->IsReached(m_syncPoint))
+            Resolve();
+        return m_ready;
+    }
+
+    auto Readback::GetData() const -> const std::vector<uint8_t>&
+    {
+        static const std::vector<uint8_t> NoData;
+        return m_ready ? m_data : NoData;
+    }
+
+    Readback::Readback(Context* context, const StagingAllocation& allocation, uint64_t size)
+        : m_ctx(context)
+        , m_allocation(allocation)
+        , m_size(size)
+    {
+    }
+
+    void Readback::Resolve()
+    {
+        if(m_ready)
+            return;
+
+        m_allocation.pBuffer->Invalidate(m_allocation.Offset, m_size);
+        m_data.resize(m_size);
+        std::memcpy(m_data.data(), m_allocation.pMapped, m_size);
+
+        m_allocation = {}; // The ring may be reset from here on.
+        m_ready = true;
+    }
+
+} // namespace VkMana
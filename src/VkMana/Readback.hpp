@@ -0,0 +1,51 @@
+#pragma once
+
+#include "StagingRing.hpp"
+#include "VulkanCommon.hpp"
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace VkMana
+{
+    class Context;
+
+    /**
+     * GPU data copied into a frame's readback ring by CommandBuffer::ReadbackBuffer/ReadbackImage.
+     * Becomes ready once its submission has completed, at the latest when its frame slot is reused. Never stalls.
+     * Use Context::Wait(GetSyncPoint()) when the data is needed immediately.
+     */
+    class Readback : public ThreadSafeIntrusivePtrEnabled<Readback>
+    {
+    public:
+        ~Readback() = default;
+
+        bool IsReady(); // Thread-safe. Copies the data out of the ring on the first call after completion.
+
+        auto GetData() const -> const std::vector<uint8_t>&; // Empty until ready.
+        auto GetSize() const -> auto { return m_size; }
+        auto GetSyncPoint() const -> auto { return m_syncPoint; } // Valid once the command buffer has been submitted.
+
+    private:
+        friend class Context;
+        friend class CommandBuffer;
+
+        Readback(Context* context, const StagingAllocation& allocation, uint64_t size);
+
+        void Resolve(); // Expects m_mutex to be held, the submission to have completed & the ring not yet reset.
+
+    private:
+        Context* m_ctx;
+        StagingAllocation m_allocation;
+        uint64_t m_size;
+        SyncPoint m_syncPoint;
+        bool m_submitted = false;
+
+        std::mutex m_mutex;
+        std::atomic_bool m_ready = false;
+        std::vector<uint8_t> m_data;
+    };
+    using ReadbackHandle = IntrusivePtr<Readback>;
+
+} // namespace VkMana
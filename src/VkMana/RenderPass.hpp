@@ -35,7 +35,7 @@ namespace VkMana
                 .clear = true,
                 .store = false,
                 .clearValue = { 1.0f, 0.0f, 0.0f, 0.0f },
-                .preLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
+                .preLayout = vk::ImageLayout::eUndefined, // Not stored, so may be a transient or aliased image.
                 .postLayout = vk::ImageLayout::eDepthStencilAttachmentOptimal,
             };
         }
@@ -0,0 +1,84 @@
+#include "StagingRing.hpp"
+
+#include "Context.hpp"
+
+#include <cstring>
+
+namespace VkMana
+{
+    namespace
+    {
+        auto AlignUp(uint64_t value, uint64_t alignment) -> uint64_t { return (value + alignment - 1) / alignment * alignment; }
+
+    } // namespace
+
+    auto StagingRing::Allocate(uint64_t size, uint64_t alignment) -> StagingAllocation
+    {
+        while(true)
+        {
+            if(m_blockIndex < m_blocks.size())
+            {
+                auto& block = m_blocks[m_blockIndex];
+                const auto offset = AlignUp(m_offset, alignment);
+                if(offset + size <= block.Buffer->GetSize())
+                {
+                    m_offset = offset + size;
+                    return { block.Buffer.Get(), offset, block.pMapped + offset };
+                }
+
+                // Move on to the next block. The remainder of this one is wasted until Reset.
+                ++m_blockIndex;
+                m_offset = 0;
+                continue;
+            }
+
+            if(!AddBlock(size))
+                return {};
+        }
+    }
+
+    auto StagingRing::Allocate(const void* pData, uint64_t size, uint64_t alignment) -> StagingAllocation
+    {
+        auto allocation = Allocate(size, alignment);
+        if(allocation.pMapped != nullptr)
+        {
+            std::memcpy(allocation.pMapped, pData, size);
+            allocation.pBuffer->Flush(allocation.Offset, size);
+        }
+        return allocation;
+    }
+
+    void StagingRing::Reset()
+    {
+        // Keep the blocks that were needed since the last reset, so steady-state use never allocates.
+        // Blocks beyond that (e.g. from a loading spike) are released.
+        const auto usedBlockCount = std::min(uint32_t(m_blocks.size()), m_blockIndex + 1);
+        m_blocks.resize(usedBlockCount);
+
+        m_blockIndex = 0;
+        m_offset = 0;
+    }
+
+    StagingRing::StagingRing(Context* context, bool readback)
+        : m_ctx(context)
+        , m_readback(readback)
+    {
+    }
+
+    bool StagingRing::AddBlock(uint64_t minSize)
+    {
+        const auto size = std::max(StagingBlockSize, AlignUp(minSize, StagingBlockSize));
+        auto buffer = m_ctx->CreateBuffer(m_readback ? BufferCreateInfo::Readback(size) : BufferCreateInfo::Staging(size));
+        if(buffer == nullptr)
+        {
+            VM_ERR("Failed to create staging block ({} bytes)", size);
+            return false;
+        }
+        buffer->SetDebugName(m_readback ? "ReadbackRing Block" : "StagingRing Block");
+
+        // Created persistently mapped.
+        m_blocks.push_back({ buffer, buffer->GetMappedData() });
+        return true;
+    }
+
+} // namespace VkMana
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "VulkanCommon.hpp"
+
+#include <vector>
+
+namespace VkMana
+{
+    class Context;
+
+    constexpr uint64_t StagingBlockSize = 8 * 1024 * 1024;
+    constexpr uint64_t StagingAlignment = 16; // Covers the texel size of every uncompressed format & buffer copy offset requirements.
+
+    struct StagingAllocation
+    {
+        const Buffer* pBuffer = nullptr;
+        uint64_t Offset = 0;
+        uint8_t* pMapped = nullptr; // Already offset.
+    };
+
+    /**
+     * Linear sub-allocator over persistently mapped staging blocks (or host-cached readback blocks).
+     * Owned by something that knows when the GPU has finished reading (e.g. a frame slot), which then calls Reset.
+     * Grows by adding blocks. Blocks unused since the last Reset are released.
+     */
+    class StagingRing : public IntrusivePtrEnabled<StagingRing>
+    {
+    public:
+        ~StagingRing() = default;
+
+        auto Allocate(uint64_t size, uint64_t alignment = StagingAlignment) -> StagingAllocation;
+        auto Allocate(const void* pData, uint64_t size, uint64_t alignment = StagingAlignment) -> StagingAllocation; // Allocate & copy.
+
+        void Reset();
+
+    private:
+        friend class Context;
+        friend class UploadContext;
+
+        explicit StagingRing(Context* context, bool readback = false);
+
+        bool AddBlock(uint64_t minSize);
+
+    private:
+        Context* m_ctx;
+        bool m_readback; // Blocks are copy destinations read by the host.
+
+        struct Block
+        {
+            BufferHandle Buffer;
+            uint8_t* pMapped = nullptr;
+        };
+        std::vector<Block> m_blocks;
+        uint32_t m_blockIndex = 0;
+        uint64_t m_offset = 0;
+    };
+    using StagingRingHandle = IntrusivePtr<StagingRing>;
+
+} // namespace VkMana
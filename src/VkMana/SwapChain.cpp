@@ -61,6 +61,7 @@ namespace VkMana
 
     SwapChain::~SwapChain()
     {
+        auto lock = m_pContext->LockQueue(QueueType::Graphics);
         m_pContext->GetGraphicsQueue().waitIdle();
         m_pContext->GetDevice().destroy(m_presentFence);
         m_pContext->GetDevice().destroy(m_swapChain);
@@ -73,7 +74,10 @@ namespace VkMana
         presentInfo.setImageIndices(m_backBufferIndex);
         presentInfo.setSwapchains(m_swapChain);
 
-        UNUSED(m_pContext->GetGraphicsQueue().presentKHR(presentInfo)); // #TODO: Handle result. e.g. Resize SwapChain?
+        {
+            auto lock = m_pContext->LockQueue(QueueType::Graphics);
+            UNUSED(m_pContext->GetGraphicsQueue().presentKHR(presentInfo)); // #TODO: Handle result. e.g. Resize SwapChain?
+        }
 
         AcquireNextImage();
     }
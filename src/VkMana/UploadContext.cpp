@@ -0,0 +1,215 @@
+#include "UploadContext.hpp"
+
+#include "Context.hpp"
+
+namespace VkMana
+{
+    namespace
+    {
+        // Release half of a queue family ownership transfer. The destination scope is ignored for releases.
+        void ReleaseImage(vk::CommandBuffer cmd, const Image* pImage, vk::ImageLayout newLayout, uint32_t srcQueueFamily, uint32_t dstQueueFamily)
+        {
+            vk::ImageMemoryBarrier2 barrier{};
+            barrier.setImage(pImage->GetImage());
+            barrier.setOldLayout(vk::ImageLayout::eTransferDstOptimal);
+            barrier.setNewLayout(newLayout);
+            barrier.setSrcStageMask(vk::PipelineStageFlagBits2::eTransfer);
+            barrier.setSrcAccessMask(vk::AccessFlagBits2::eTransferWrite);
+            barrier.setSrcQueueFamilyIndex(srcQueueFamily);
+            barrier.setDstQueueFamilyIndex(dstQueueFamily);
+            barrier.subresourceRange.setAspectMask(pImage->GetAspect());
+            barrier.subresourceRange.setBaseMipLevel(0);
+            barrier.subresourceRange.setLevelCount(pImage->GetMipLevels());
+            barrier.subresourceRange.setBaseArrayLayer(0);
+            barrier.subresourceRange.setLayerCount(pImage->GetDepthOrArrayLayers());
+
+            vk::DependencyInfo depInfo{};
+            depInfo.setImageMemoryBarriers(barrier);
+            cmd.pipelineBarrier2(depInfo);
+        }
+
+    } // namespace
+
+    UploadContext::~UploadContext()
+    {
+        WaitIdle();
+        m_inFlightBatches.clear();
+        m_freeStagingRings.clear();
+        m_freeCmdPools.clear();
+        m_batch = {};
+        m_cmd = nullptr;
+    }
+
+    void UploadContext::UploadBuffer(const BufferHandle& buffer, const BufferDataSource& data, uint64_t dstOffset)
+    {
+        auto& cmd = GetCmd();
+        const auto staging = AllocateStaging(data.pData, data.size);
+        if(staging.pBuffer == nullptr)
+            return;
+
+        BufferCopyInfo copyInfo{
+            .pSrcBuffer = staging.pBuffer,
+            .pDstBuffer = buffer.Get(),
+            .size = data.size,
+            .srcOffset = staging.Offset,
+            .dstOffset = dstOffset,
+        };
+        cmd.CopyBuffer(copyInfo);
+
+        BufferBarrierInfo barrierInfo{
+            .pBuffer = buffer.Get(),
+            .srcStage = vk::PipelineStageFlagBits2::eTransfer,
+            .srcAccess = vk::AccessFlagBits2::eTransferWrite,
+        };
+        if(m_srcQueueFamily != m_dstQueueFamily)
+        {
+            // Release to the graphics queue.
+            barrierInfo.srcQueueFamily = m_srcQueueFamily;
+            barrierInfo.dstQueueFamily = m_dstQueueFamily;
+            m_ownershipTransfer.Buffers.push_back(buffer);
+        }
+        else
+        {
+            barrierInfo.dstStage = vk::PipelineStageFlagBits2::eAllCommands;
+            barrierInfo.dstAccess = vk::AccessFlagBits2::eMemoryRead;
+        }
+        cmd.BufferBarrier(barrierInfo);
+    }
+
+    void UploadContext::UploadImage(const ImageHandle& image, const ImageDataSource& data, bool genMipMaps)
+    {
+        auto& cmd = GetCmd();
+        const auto staging = AllocateStaging(data.data, data.size);
+        if(staging.pBuffer == nullptr)
+            return;
+
+        ImageTransitionInfo preTransitionInfo{
+            .pImage = image.Get(),
+            .oldLayout = vk::ImageLayout::eUndefined,
+            .newLayout = vk::ImageLayout::eTransferDstOptimal,
+            .mipLevelCount = image->GetMipLevels(),
+            .arrayLayerCount = image->GetDepthOrArrayLayers(),
+        };
+        cmd.TransitionImage(preTransitionInfo);
+
+        BufferToImageCopyInfo copyInfo{
+            .pSrcBuffer = staging.pBuffer,
+            .pDstImage = image.Get(),
+            .srcOffset = staging.Offset,
+            .subresources = data.subresources,
+        };
+        cmd.CopyBufferToImage(copyInfo);
+
+        genMipMaps = genMipMaps && image->GetMipLevels() > 1 && !data.HasMipChain();
+        if(genMipMaps)
+        {
+            // Mips are generated by the next graphics submission, whose frame owns the descriptor sets & views they need.
+            // Blits also require a graphics queue. With an aliased transfer queue the image is only waited on, not released.
+            if(m_srcQueueFamily != m_dstQueueFamily)
+                ReleaseImage(cmd.GetCmd(), image.Get(), vk::ImageLayout::eTransferDstOptimal, m_srcQueueFamily, m_dstQueueFamily);
+            m_ownershipTransfer.MipMapImages.push_back(image);
+        }
+        else if(m_srcQueueFamily != m_dstQueueFamily)
+        {
+            ReleaseImage(cmd.GetCmd(), image.Get(), vk::ImageLayout::eShaderReadOnlyOptimal, m_srcQueueFamily, m_dstQueueFamily);
+            m_ownershipTransfer.Images.push_back(image);
+        }
+        else
+        {
+            ImageTransitionInfo postTransitionInfo{
+                .pImage = image.Get(),
+                .oldLayout = vk::ImageLayout::eTransferDstOptimal,
+                .newLayout = vk::ImageLayout::eShaderReadOnlyOptimal,
+                .mipLevelCount = image->GetMipLevels(),
+                .arrayLayerCount = image->GetDepthOrArrayLayers(),
+            };
+            cmd.TransitionImage(postTransitionInfo);
+        }
+    }
+
+    auto UploadContext::Submit() -> uint64_t
+    {
+        if(!m_cmd)
+            return m_lastSubmittedValue;
+
+        m_batch.TimelineValue = m_ctx->SubmitUpload(std::move(m_cmd), std::move(m_ownershipTransfer));
+        m_lastSubmittedValue = m_batch.TimelineValue;
+        m_inFlightBatches.push_back(std::move(m_batch));
+
+        m_cmd = nullptr;
+        m_batch = {};
+        m_ownershipTransfer = {};
+        return m_lastSubmittedValue;
+    }
+
+    bool UploadContext::IsComplete(uint64_t timelineValue) const { return m_ctx->IsTimelineValueReached(QueueType::Transfer, timelineValue); }
+
+    void UploadContext::Wait(uint64_t timelineValue) const { m_ctx->WaitForTimelineValue(QueueType::Transfer, timelineValue); }
+
+    void UploadContext::WaitIdle() const { Wait(m_lastSubmittedValue); }
+
+    UploadContext::UploadContext(Context* context)
+        : m_ctx(context)
+        , m_srcQueueFamily(context->GetQueueFamily(QueueType::Transfer))
+        , m_dstQueueFamily(context->GetQueueFamily(QueueType::Graphics))
+    {
+    }
+
+    auto UploadContext::GetCmd() -> CommandBuffer&
+    {
+        if(!m_cmd)
+        {
+            RetireBatches();
+
+            if(!m_freeCmdPools.empty())
+            {
+                m_batch.CmdPool = m_freeCmdPools.back();
+                m_freeCmdPools.pop_back();
+            }
+            else
+            {
+                m_batch.CmdPool = IntrusivePtr(new CommandPool(m_ctx, m_srcQueueFamily));
+            }
+
+            auto cmd = m_batch.CmdPool->RequestCmd();
+            vk::CommandBufferBeginInfo beginInfo{};
+            beginInfo.setFlags(vk::CommandBufferUsageFlagBits::eOneTimeSubmit);
+            cmd.begin(beginInfo);
+            m_cmd = IntrusivePtr(new CommandBuffer(m_ctx, cmd, QueueType::Transfer));
+
+            if(!m_freeStagingRings.empty())
+            {
+                m_batch.Staging = m_freeStagingRings.back();
+                m_freeStagingRings.pop_back();
+            }
+            else
+            {
+                m_batch.Staging = IntrusivePtr(new StagingRing(m_ctx));
+            }
+        }
+        return *m_cmd;
+    }
+
+    auto UploadContext::AllocateStaging(const void* pData, uint64_t size) -> StagingAllocation
+    {
+        auto staging = m_batch.Staging->Allocate(pData, size);
+        if(staging.pBuffer == nullptr)
+            VM_ERR("Failed to upload data (Staging allocation failed)");
+        return staging;
+    }
+
+    void UploadContext::RetireBatches()
+    {
+        std::erase_if(m_inFlightBatches, [this](auto& batch) {
+            if(!IsComplete(batch.TimelineValue))
+                return false;
+
+            batch.Staging->Reset();
+            m_freeStagingRings.push_back(std::move(batch.Staging));
+            batch.CmdPool->ResetPool();
+            m_freeCmdPools.push_back(std::move(batch.CmdPool));
+            return true;
+        });
+    }
+
+} // namespace VkMana
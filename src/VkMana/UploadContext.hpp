@@ -0,0 +1,76 @@
+#pragma once
+
+#include "Buffer.hpp"
+#include "CommandBuffer.hpp"
+#include "CommandPool.hpp"
+#include "Image.hpp"
+#include "StagingRing.hpp"
+#include "VulkanCommon.hpp"
+
+#include <vector>
+
+namespace VkMana
+{
+    class Context;
+
+    /**
+     * Resources released by the transfer queue.
+     * Acquired by the graphics queue on its next submission after the transfer has been submitted.
+     */
+    struct QueueOwnershipTransfer
+    {
+        uint64_t TransferValue = 0; // Transfer timeline value the release has completed at.
+        std::vector<BufferHandle> Buffers;
+        std::vector<ImageHandle> Images;       // Released in ShaderReadOnly.
+        std::vector<ImageHandle> MipMapImages; // Left in TransferDst. Mips are generated on the graphics queue after acquiring.
+    };
+
+    /**
+     * Records uploads on the transfer queue with its own command pool & staging rings.
+     * Not thread-safe itself, use one UploadContext per worker thread.
+     */
+    class UploadContext : public IntrusivePtrEnabled<UploadContext>
+    {
+    public:
+        ~UploadContext();
+
+        void UploadBuffer(const BufferHandle& buffer, const BufferDataSource& data, uint64_t dstOffset = 0);
+        void UploadImage(const ImageHandle& image, const ImageDataSource& data, bool genMipMaps = false);
+
+        auto Submit() -> uint64_t; // Returns the transfer timeline value signalled once all recorded uploads have completed.
+
+        bool IsComplete(uint64_t timelineValue) const;
+        void Wait(uint64_t timelineValue) const;
+        void WaitIdle() const;
+
+    private:
+        friend class Context;
+
+        explicit UploadContext(Context* context);
+
+        auto GetCmd() -> CommandBuffer&;
+        auto AllocateStaging(const void* pData, uint64_t size) -> StagingAllocation;
+        void RetireBatches();
+
+    private:
+        Context* m_ctx;
+        uint32_t m_srcQueueFamily;
+        uint32_t m_dstQueueFamily;
+
+        struct Batch
+        {
+            uint64_t TimelineValue = 0;
+            StagingRingHandle Staging;         // Reset & reused once the batch has completed.
+            IntrusivePtr<CommandPool> CmdPool; // Same, so a worker that always has a batch in flight still reuses its command buffers.
+        };
+        CmdBuffer m_cmd = nullptr;
+        Batch m_batch;
+        std::vector<Batch> m_inFlightBatches;
+        std::vector<StagingRingHandle> m_freeStagingRings;
+        std::vector<IntrusivePtr<CommandPool>> m_freeCmdPools;
+        QueueOwnershipTransfer m_ownershipTransfer;
+        uint64_t m_lastSubmittedValue = 0;
+    };
+    using UploadContextHandle = IntrusivePtr<UploadContext>;
+
+} // namespace VkMana
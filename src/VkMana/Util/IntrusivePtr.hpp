@@ -25,7 +25,7 @@ namespace VkMana
         inline bool Release()
         {
             auto result = m_count.fetch_sub(1, std::memory_order_acq_rel);
-            return result == 0;
+            return result == 1;
         }
 
     private:
@@ -9,6 +9,32 @@
 
 namespace VkMana
 {
+    enum class QueueType : uint8_t
+    {
+        Graphics,
+        Transfer, // Dedicated transfer family if available, otherwise aliases the graphics queue.
+        Compute,  // Dedicated compute family if available, otherwise aliases the graphics queue.
+        Count,
+    };
+
+    /**
+     * A point on a queue's timeline. Returned by submissions so other submissions (or the host) can wait on them.
+     */
+    struct SyncPoint
+    {
+        QueueType Queue = QueueType::Graphics;
+        uint64_t Value = 0; // Zero is always reached.
+    };
+
+    enum class MemoryCategory : uint8_t
+    {
+        Buffer,       // Vertex, index, uniform & storage buffers.
+        Staging,      // Host-accessible buffers only used for transfers (staging & readback).
+        Texture,
+        RenderTarget, // Images usable as color/depth attachments.
+        Count,
+    };
+
     template <typename T>
     void SetObjectDebugName(vk::Device device, T handle, const char* pName)
     {
@@ -90,6 +116,46 @@ namespace VkMana
 
     inline bool FormatIsColor(vk::Format format) { return !(FormatIsUndefined(format) || FormatIsDepthOrStencil(format)); }
 
+    // Size of one texel in bytes for common uncompressed color formats. 0 if unknown.
+    inline auto FormatGetTexelSize(vk::Format format) -> uint32_t
+    {
+        switch(format)
+        {
+        case vk::Format::eR8Unorm:
+        case vk::Format::eR8Snorm:
+        case vk::Format::eR8Uint:
+        case vk::Format::eR8Sint:
+            return 1;
+        case vk::Format::eR8G8Unorm:
+        case vk::Format::eR8G8Snorm:
+        case vk::Format::eR16Sfloat:
+        case vk::Format::eR16Uint:
+        case vk::Format::eR16Sint:
+            return 2;
+        case vk::Format::eR8G8B8A8Unorm:
+        case vk::Format::eR8G8B8A8Snorm:
+        case vk::Format::eR8G8B8A8Srgb:
+        case vk::Format::eB8G8R8A8Unorm:
+        case vk::Format::eB8G8R8A8Srgb:
+        case vk::Format::eA2B10G10R10UnormPack32:
+        case vk::Format::eB10G11R11UfloatPack32:
+        case vk::Format::eR16G16Sfloat:
+        case vk::Format::eR32Sfloat:
+        case vk::Format::eR32Uint:
+        case vk::Format::eR32Sint:
+            return 4;
+        case vk::Format::eR16G16B16A16Sfloat:
+        case vk::Format::eR32G32Sfloat:
+        case vk::Format::eR32G32Uint:
+            return 8;
+        case vk::Format::eR32G32B32A32Sfloat:
+        case vk::Format::eR32G32B32A32Uint:
+            return 16;
+        default:
+            return 0;
+        }
+    }
+
 } // namespace VkMana
 
 #define UNUSED(x) (void(x))
\ No newline at end of file